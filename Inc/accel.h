@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file    Inc/accel.h
+  * @brief   Header for accel.c module - LIS3DSH telemetry over SPI1 DMA
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __ACCEL_H
+#define __ACCEL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* Telemetry frame, a packet (see packet.h) with payload
+     ACCEL_FRAME_TYPE | varint index | varint period_us | count | sample...
+   index numbers the sample periods since Accel_Start(), so a gap in it
+   shows samples lost on the device. Each sample is three zigzag varints,
+   x y z, holding the difference to the previous sample of the frame; the
+   first one is relative to zero. Raw values are LIS3DSH counts, 0.06 mg
+   each at the +-2 g range. tools/accel_rx.py decodes the frames. */
+#define ACCEL_FRAME_TYPE    0x03U
+
+/* Port the frames go out on */
+#ifndef ACCEL_PORT
+#define ACCEL_PORT UART_PORT_HC05
+#endif
+
+/* Samples per frame. A frame of worst-case deltas, three 3-byte varints per
+   sample after a 10-byte header, must fit PACKET_MAX_PAYLOAD. */
+#ifndef ACCEL_BATCH
+#define ACCEL_BATCH 24
+#endif
+
+/* Batches the sampling interrupt can fill ahead of the main loop, and
+   frames in flight on the TX queue; both powers of two */
+#define ACCEL_BATCHES 4
+#define ACCEL_FRAMES  4
+
+/* Highest sample rate; the sensor runs at the next output data rate at or
+   above the requested one */
+#define ACCEL_MAX_HZ 1600
+
+/* LIS3DSH chip select on PE3, SPI1 on PA5/PA6/PA7 */
+#define ACCEL_CS_PORT   GPIOE
+#define ACCEL_CS_PIN    GPIO_PIN_3
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+    uint32_t rate_hz;       /* sample rate of the current or last run */
+    uint32_t samples;       /* samples read from the sensor */
+    uint32_t dropped;       /* samples lost because every batch was full */
+    uint32_t overruns;      /* sample periods skipped, SPI still busy */
+    uint32_t frames;        /* frames queued on the port */
+    uint32_t bytes;         /* encoded frame bytes, delimiters included */
+} Accel_StatsTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef Accel_Init(void);
+HAL_StatusTypeDef Accel_Start(uint32_t rate_hz);
+void Accel_Stop(void);
+bool Accel_IsRunning(void);
+void Accel_Poll(void);
+void Accel_GetStats(Accel_StatsTypeDef *stats);
+void Accel_TransferCompleteISR(SPI_HandleTypeDef *hspi);
+void Accel_TIM_IRQHandler(void);
+void Accel_DMA_RX_IRQHandler(void);
+void Accel_DMA_TX_IRQHandler(void);
+
+/* Called from interrupt context when a batch is ready for Accel_Poll(); the
+   application wakes its main loop from here */
+void Accel_ReadyCallback(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ACCEL_H */
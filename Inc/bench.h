@@ -0,0 +1,88 @@
+/**
+  ******************************************************************************
+  * @file    Inc/bench.h
+  * @brief   Header for bench.c module - on-target link benchmarks
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* Line time spent at each rate by the baud sweep */
+#define BENCH_SWEEP_MS 200
+
+/* Every rate change restarts the HC-05 and drops the Bluetooth connection;
+   the sweep and bus contention reports wait this long for the remote side
+   to reconnect */
+#define BENCH_SWEEP_RECONNECT_MS 10000
+
+/* Rounds of UART_TX_QUEUE_LEN one-byte spans timed per TX path */
+#define BENCH_COST_ROUNDS 8
+
+/* Passes of the memory-heavy loop timed by the bus contention benchmark */
+#define BENCH_COPY_PASSES 64
+
+/* Slowest rate the bus contention benchmark runs at. Below it the TX DMA
+   requests a byte so rarely that the slowdown is lost in the noise; the
+   benchmark moves the link to the fastest rate the HC-05 accepts */
+#define BENCH_CONTENTION_MIN_BAUD 460800
+
+/* Pattern frame stream. Each frame is a packet (see packet.h) with payload
+     BENCH_FRAME_TYPE | seq u32 LE | t_us u32 LE | pattern
+   where pattern byte i is (seq + i) & 0xFF and t_us is the device time in
+   microseconds when the frame was queued. tools/bench_rx.py checks them. */
+#define BENCH_FRAME_TYPE        0x02U
+#define BENCH_FRAME_HEADER      9U
+
+/* Payload bytes per frame, header included, at most PACKET_MAX_PAYLOAD */
+#ifndef BENCH_FRAME_PAYLOAD
+#define BENCH_FRAME_PAYLOAD 64
+#endif
+
+/* Frames kept in flight, must be a power of two */
+#define BENCH_FRAMES 8
+
+/* Default stream duration */
+#define BENCH_STREAM_MS 10000
+
+/* Set to 1 to have the user button start and stop the stream instead of
+   sending the message */
+#ifndef BENCH_STREAM_ON_BUTTON
+#define BENCH_STREAM_ON_BUTTON 0
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+    uint32_t frames;        /* frames queued */
+    uint32_t bytes;         /* encoded bytes queued, delimiters included */
+    uint32_t elapsed_ms;    /* run time so far, or of the last run */
+    uint32_t starved;       /* times the TX queue was found empty */
+    uint32_t baud;          /* link rate of the run */
+} BENCH_StreamStatsTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef BENCH_BaudSweep(void);
+HAL_StatusTypeDef BENCH_BusContention(void);
+HAL_StatusTypeDef BENCH_TxCost(void);
+void BENCH_StreamStart(uint32_t duration_ms);
+void BENCH_StreamStop(void);
+bool BENCH_StreamIsRunning(void);
+void BENCH_StreamPoll(void);
+void BENCH_StreamGetStats(BENCH_StreamStatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BENCH_H */
@@ -0,0 +1,84 @@
+/**
+  ******************************************************************************
+  * @file    Inc/cmd.h
+  * @brief   Header for cmd.c module - line commands parsed from the RX ring
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CMD_H
+#define __CMD_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+/* No HAL here: tools/cmd_bench.c builds the parser on the host */
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* Longest line that can be carried over a split in the received data */
+#ifndef CMD_LINE_MAX
+#define CMD_LINE_MAX 128
+#endif
+
+/* Perfect hash of the command names, from tools/cmd_phash.py:
+   slot = (name[0] * A + name[len - 1] * B + len) & (SIZE - 1) */
+#define CMD_HASH_SIZE 32
+#define CMD_HASH_A    1U
+#define CMD_HASH_B    3U
+
+/* Exported types ------------------------------------------------------------*/
+/* Argument text after the command name, not terminated; it points into the
+   received data or the parser's carry buffer and is valid until return */
+typedef void (*Cmd_HandlerTypeDef)(const char *arg, uint16_t len);
+
+typedef struct
+{
+    const char *name;
+    uint8_t len;
+    Cmd_HandlerTypeDef handler;
+} Cmd_EntryTypeDef;
+
+typedef struct
+{
+    uint32_t lines;         /* non-empty lines seen */
+    uint32_t dispatched;    /* lines that named a command */
+    uint32_t unknown;       /* lines that did not */
+    uint32_t carried;       /* lines split across spans, copied to parse */
+    uint32_t overflow;      /* lines longer than CMD_LINE_MAX, dropped */
+} Cmd_StatsTypeDef;
+
+/* Parser state of one byte stream */
+typedef struct
+{
+    uint16_t carry_len;     /* bytes of a split line kept in carry */
+    uint8_t discard;        /* skipping the rest of an overlong line */
+    char carry[CMD_LINE_MAX];
+    Cmd_StatsTypeDef stats;
+} Cmd_ParserTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+void Cmd_Init(Cmd_ParserTypeDef *parser);
+void Cmd_Feed(Cmd_ParserTypeDef *parser, const uint8_t *data, uint16_t len);
+const Cmd_EntryTypeDef *Cmd_Lookup(const char *name, uint16_t len);
+
+/* Command handlers, provided by the application */
+void Cmd_OnHelp(const char *arg, uint16_t len);
+void Cmd_OnMsg(const char *arg, uint16_t len);
+void Cmd_OnBaud(const char *arg, uint16_t len);
+void Cmd_OnStats(const char *arg, uint16_t len);
+void Cmd_OnEvents(const char *arg, uint16_t len);
+void Cmd_OnProf(const char *arg, uint16_t len);
+void Cmd_OnSweep(const char *arg, uint16_t len);
+void Cmd_OnBench(const char *arg, uint16_t len);
+void Cmd_OnStream(const char *arg, uint16_t len);
+void Cmd_OnAccel(const char *arg, uint16_t len);
+void Cmd_OnTxCost(const char *arg, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CMD_H */
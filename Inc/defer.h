@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    Inc/defer.h
+  * @brief   Header for defer.c module - deferred work run from PendSV
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DEFER_H
+#define __DEFER_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Work items that can wait for PendSV at once, must be a power of two */
+#ifndef DEFER_QUEUE_SIZE
+#define DEFER_QUEUE_SIZE 32
+#endif
+
+#if (DEFER_QUEUE_SIZE & (DEFER_QUEUE_SIZE - 1)) != 0
+#error "DEFER_QUEUE_SIZE must be a power of two"
+#endif
+
+/* PendSV preemption priority, the lowest the NVIC implements */
+#define DEFER_IRQ_PRIORITY 0x0FU
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (*Defer_FuncTypeDef)(uint32_t arg);
+
+typedef struct
+{
+    uint32_t posted;        /* items queued */
+    uint32_t run;           /* items executed */
+    uint32_t dropped;       /* items refused because the queue was full */
+    uint32_t depth_max;     /* most items waiting at once */
+} Defer_StatsTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+void Defer_Init(void);
+HAL_StatusTypeDef Defer_Post(Defer_FuncTypeDef func, uint32_t arg);
+void Defer_IRQHandler(void);
+void Defer_GetStats(Defer_StatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DEFER_H */
@@ -0,0 +1,55 @@
+/**
+  ******************************************************************************
+  * @file    Inc/event.h
+  * @brief   Header for event.c module - event flags and the sleeping main loop
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __EVENT_H
+#define __EVENT_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* 1: Event_Wait() sleeps with WFI until an interrupt arrives.
+   0: it spins, kept to compare the dispatch latency against */
+#ifndef EVENT_SLEEP
+#define EVENT_SLEEP 1
+#endif
+
+/* 1: also set SLEEPONEXIT so interrupts that post nothing (SysTick every
+   millisecond) go straight back to sleep without resuming main() */
+#ifndef EVENT_SLEEP_ON_EXIT
+#define EVENT_SLEEP_ON_EXIT 0
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+    uint32_t wakeups;       /* times main() resumed from sleep */
+    uint32_t dispatched;    /* Event_Wait() calls that returned events */
+    uint32_t lat_min;       /* cycles from the first Event_Post() to the */
+    uint32_t lat_max;       /*   return of Event_Wait() */
+    uint64_t lat_total;
+    uint64_t sleep_cycles;  /* core clock cycles spent asleep */
+    uint32_t start_tick;    /* HAL tick when the statistics were cleared */
+} Event_StatsTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+void Event_Init(void);
+void Event_Post(uint32_t events);
+uint32_t Event_Wait(void);
+void Event_GetStats(Event_StatsTypeDef *stats);
+HAL_StatusTypeDef Event_Dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EVENT_H */
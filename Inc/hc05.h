@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * @file    Inc/hc05.h
+  * @brief   Header for hc05.c module - HC-05 link rate control
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __HC05_H
+#define __HC05_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* HC-05 KEY/EN input, held high to make the module accept AT commands */
+#define HC05_KEY_PORT           GPIOD
+#define HC05_KEY_PIN            GPIO_PIN_0
+
+/* Rate used at power-up, the HC-05 factory default */
+#define HC05_DEFAULT_BAUDRATE   9600
+
+/* Time allowed for the module to answer one AT command */
+#define HC05_AT_TIMEOUT_MS      500
+
+/* Time the module needs to boot after AT+RESET */
+#define HC05_RESET_MS           1000
+
+/* Exported variables --------------------------------------------------------*/
+/* Rates the HC-05 accepts in AT+UART, in increasing order */
+extern const uint32_t hc05_baudrates[];
+extern const uint32_t hc05_baudrate_count;
+
+/* Exported functions ------------------------------------------------------- */
+void HC05_Init(UART_PortTypeDef port);
+HAL_StatusTypeDef HC05_SetBaudRate(uint32_t baud);
+uint32_t HC05_GetBaudRate(void);
+void HC05_RxFeed(const uint8_t *data, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HC05_H */
@@ -0,0 +1,92 @@
+/**
+  ******************************************************************************
+  * @file    Inc/irq_prof.h
+  * @brief   Header for irq_prof.c module - DWT cycle counts per interrupt
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __IRQ_PROF_H
+#define __IRQ_PROF_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Set to 1 (e.g. from the compiler command line) to build the profiler in */
+#ifndef IRQ_PROF_ENABLED
+#define IRQ_PROF_ENABLED 0
+#endif
+
+/* Log2 histogram buckets: bucket n counts durations in [2^n, 2^(n+1)) cycles,
+   the last bucket also takes everything longer */
+#define IRQ_PROF_BUCKETS 16
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+    IRQ_PROF_SYSTICK = 0,
+    IRQ_PROF_EXTI0,
+    IRQ_PROF_DMA2_STREAM1,
+    IRQ_PROF_DMA2_STREAM6,
+    IRQ_PROF_USART6,
+    IRQ_PROF_PENDSV,
+    IRQ_PROF_TIM3,
+    IRQ_PROF_DMA2_STREAM0,
+    IRQ_PROF_DMA2_STREAM3,
+    IRQ_PROF_TX_CPLT,           /* HAL_UART_TxCpltCallback() alone */
+    IRQ_PROF_COUNT
+} IRQ_Prof_IdTypeDef;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t hist[IRQ_PROF_BUCKETS];
+} IRQ_Prof_StatTypeDef;
+
+typedef struct
+{
+    IRQ_Prof_StatTypeDef exec;      /* cycles spent in the handler */
+    IRQ_Prof_StatTypeDef latency;   /* cycles from the event to handler entry,
+                                       only where the hardware tells us */
+} IRQ_Prof_EntryTypeDef;
+
+/* Exported macro ------------------------------------------------------------*/
+#if IRQ_PROF_ENABLED
+
+#define IRQ_PROF_ENTER(id)              uint32_t irq_prof_t0_ = DWT->CYCCNT
+#define IRQ_PROF_EXIT(id)               IRQ_Prof_Record(&irq_prof[(id)].exec, DWT->CYCCNT - irq_prof_t0_)
+#define IRQ_PROF_LATENCY(id, cycles)    IRQ_Prof_Record(&irq_prof[(id)].latency, (cycles))
+
+extern IRQ_Prof_EntryTypeDef irq_prof[IRQ_PROF_COUNT];
+
+/* Exported functions ------------------------------------------------------- */
+void IRQ_Prof_Init(void);
+void IRQ_Prof_Reset(void);
+void IRQ_Prof_Record(IRQ_Prof_StatTypeDef *stat, uint32_t cycles);
+HAL_StatusTypeDef IRQ_Prof_Dump(void);
+
+#else
+
+#define IRQ_PROF_ENTER(id)              do { } while (0)
+#define IRQ_PROF_EXIT(id)               do { } while (0)
+#define IRQ_PROF_LATENCY(id, cycles)    do { } while (0)
+
+#define IRQ_Prof_Init()                 do { } while (0)
+#define IRQ_Prof_Reset()                do { } while (0)
+#define IRQ_Prof_Dump()                 (HAL_ERROR)
+
+#endif /* IRQ_PROF_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IRQ_PROF_H */
@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file    Inc/led.h
+  * @brief   Header for led.c module - non-blocking LED indicators
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LED_H
+#define __LED_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+    LED_GREEN = 0,   /* PD12 */
+    LED_ORANGE,      /* PD13 */
+    LED_RED,         /* PD14 */
+    LED_BLUE,        /* PD15 */
+    LED_COUNT
+} LED_TypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Blink patterns that can wait per LED, must be a power of two */
+#define LED_QUEUE_LEN 4
+
+/* Exported functions ------------------------------------------------------- */
+void LED_On(LED_TypeDef led);
+void LED_Off(LED_TypeDef led);
+HAL_StatusTypeDef LED_Blink(LED_TypeDef led, uint8_t count, uint16_t period_ms);
+void LED_TickISR(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LED_H */
@@ -0,0 +1,60 @@
+/**
+  ******************************************************************************
+  * @file    Inc/mem_sections.h
+  * @brief   Placement of hot code, CPU-only state and DMA buffers
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MEM_SECTIONS_H
+#define __MEM_SECTIONS_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported macro ------------------------------------------------------------*/
+/* Put the macro in front of the whole declaration, e.g.
+     RAMFUNC void UART_TX_CompleteISR(void)
+     CCMRAM static uint32_t counter;
+     DMA_BUFFER static uint8_t buf[64];
+
+   RAMFUNC     code copied to SRAM at startup, fetched without flash wait
+               states or ART cache misses.
+   CCMRAM      data in the 64 KB core-coupled RAM: zero wait state for the CPU
+               and off the bus matrix, but NOT reachable by DMA.
+   DMA_BUFFER  data in SRAM1, 16-byte aligned for DMA bursts. Not initialised
+               at startup, so do not give these variables an initialiser.
+
+   The linker files place the sections (.RamFunc, .ccmram, .dma_buffer); the
+   GCC script fails the link if .dma_buffer ever ends up outside SRAM1. The
+   MDK-ARM project has no scatter file, so with Arm Compiler everything keeps
+   its default placement. */
+#if defined(__ICCARM__)
+#define RAMFUNC         __ramfunc
+#define CCMRAM          _Pragma("location=\".ccmram\"")
+#define DMA_BUFFER      _Pragma("location=\".dma_buffer\"") _Pragma("data_alignment=16")
+#elif defined(__GNUC__) && !defined(__ARMCC_VERSION)
+#define RAMFUNC         __attribute__((section(".RamFunc"), noinline))
+#define CCMRAM          __attribute__((section(".ccmram")))
+#define DMA_BUFFER      __attribute__((section(".dma_buffer"), aligned(16)))
+#else
+#define RAMFUNC
+#define CCMRAM
+#define DMA_BUFFER      __attribute__((aligned(16)))
+#endif
+
+/* CCM data RAM, the only RAM the DMA controllers cannot reach */
+#define MEM_CCMRAM_BASE     0x10000000UL
+#define MEM_CCMRAM_SIZE     0x00010000UL
+
+#define MEM_IS_DMA_SAFE(p)  (((uintptr_t)(p) - MEM_CCMRAM_BASE) >= MEM_CCMRAM_SIZE)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEM_SECTIONS_H */
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    Inc/msg.h
+  * @brief   Header for msg.c module - canned messages sent from flash
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MSG_H
+#define __MSG_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Fixed messages: X(identifier, text). Add a line here to add a message; its
+   length is taken at compile time and the text is sent from flash. */
+#define MSG_TABLE(X)                                                          \
+    X(MSG_HELLO, "Hello from STM32 via HC-05\r\n")                            \
+    X(MSG_HELP,  "commands: help, msg <text>, baud <rate>, stats, events, "   \
+                 "prof, sweep, bench, txcost, stream [seconds], accel [hz]\r\n")
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+#define MSG_ENUM_(id, text) id,
+    MSG_TABLE(MSG_ENUM_)
+#undef MSG_ENUM_
+    MSG_COUNT
+} Msg_IdTypeDef;
+
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t len;
+} Msg_EntryTypeDef;
+
+/* Exported variables --------------------------------------------------------*/
+extern const Msg_EntryTypeDef msg_table[MSG_COUNT];
+
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef Msg_Send(UART_PortTypeDef port, Msg_IdTypeDef id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MSG_H */
@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    Inc/packet.h
+  * @brief   Header for packet.c module - COBS framed packets with CRC32
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PACKET_H
+#define __PACKET_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Frame on the wire:  code | COBS(payload | crc32 LE) | 0x00
+
+   The payload is written in place at PACKET_PAYLOAD(buf), one word into the
+   buffer so the CRC unit can read it as aligned words. The COBS code byte
+   goes in the last headroom byte and the CRC and delimiter after the
+   payload, so encoding needs no second buffer. Payload plus CRC is kept
+   below 255 bytes, which means COBS never has to insert extra code bytes.
+
+   CRC32 is computed by the STM32 CRC unit: polynomial 0x04C11DB7, initial
+   value 0xFFFFFFFF, no reflection, no final XOR, over the payload read as
+   little-endian 32-bit words with the last word zero-padded. */
+#define PACKET_HEADROOM         4
+#define PACKET_TAILROOM         5     /* CRC32 + delimiter */
+#define PACKET_MAX_PAYLOAD      250
+#define PACKET_DELIMITER        0x00
+
+/* Exported macro ------------------------------------------------------------*/
+/* Buffer size for a payload of n bytes; declare it word aligned */
+#define PACKET_BUFSIZE(n)       (PACKET_HEADROOM + (n) + PACKET_TAILROOM)
+#define PACKET_PAYLOAD(buf)     (&(buf)[PACKET_HEADROOM])
+
+/* Exported functions ------------------------------------------------------- */
+void Packet_Init(void);
+uint32_t Packet_CRC(const uint8_t *data, uint16_t len);
+uint16_t Packet_Encode(uint8_t *buf, uint16_t len, uint8_t **frame);
+HAL_StatusTypeDef Packet_Send(UART_PortTypeDef port, uint8_t *buf, uint16_t len);
+int32_t Packet_Decode(uint8_t *frame, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PACKET_H */
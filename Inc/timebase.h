@@ -0,0 +1,52 @@
+/**
+  ******************************************************************************
+  * @file    Inc/timebase.h
+  * @brief   Header for timebase.c module - free-running microsecond counter
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TIMEBASE_H
+#define __TIMEBASE_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* 32-bit timer counting at TIMEBASE_HZ; it wraps every 71 minutes, so only
+   differences of time stamps less than that apart are meaningful */
+#define TIMEBASE_TIM    TIM2
+#define TIMEBASE_HZ     1000000U
+
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef Timebase_Init(void);
+
+/**
+  * @brief  Current time, one register read from any context
+  * @param  None
+  * @retval Microseconds since Timebase_Init(), wraps at 2^32
+  */
+__STATIC_INLINE uint32_t Timebase_Now(void)
+{
+    return TIMEBASE_TIM->CNT;
+}
+
+/**
+  * @brief  Time elapsed since a time stamp
+  * @param  t0: earlier Timebase_Now() value
+  * @retval Microseconds
+  */
+__STATIC_INLINE uint32_t Timebase_Since(uint32_t t0)
+{
+    return TIMEBASE_TIM->CNT - t0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMEBASE_H */
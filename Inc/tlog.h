@@ -0,0 +1,99 @@
+/**
+  ******************************************************************************
+  * @file    Inc/tlog.h
+  * @brief   Header for tlog.c module - tokenized binary logging
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TLOG_H
+#define __TLOG_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Packet payload:  TLOG_PACKET_TYPE | varint base_ms | record...
+   Record:          varint dt_ms | varint token | count | varint arg...
+
+   Varints are little-endian base-128 with the top bit of each byte set on
+   all but the last. dt_ms is the HAL tick relative to base_ms, the token is
+   the address of the format string and every argument is sent as the
+   32-bit value it was converted to. tools/tlog_decode.py looks the token up
+   in the firmware ELF and formats the message on the host. */
+#define TLOG_PACKET_TYPE    0x01U
+
+/* Port the records go out on */
+#ifndef TLOG_PORT
+#define TLOG_PORT UART_PORT_HC05
+#endif
+
+/* Packet buffers; one fills while the others are on the wire */
+#ifndef TLOG_BUFFERS
+#define TLOG_BUFFERS 4
+#endif
+
+/* Payload bytes per packet, at most PACKET_MAX_PAYLOAD */
+#ifndef TLOG_PAYLOAD
+#define TLOG_PAYLOAD 128
+#endif
+
+#define TLOG_MAX_ARGS 8
+
+/* Format strings go to a section that is never loaded (GCC, see the linker
+   script) or to flash; either way only their address reaches the target */
+#if defined(__ICCARM__)
+#define TLOG_FORMAT     _Pragma("location=\".tlog\"")
+#elif defined(__GNUC__) && !defined(__ARMCC_VERSION)
+#define TLOG_FORMAT     __attribute__((section(".tlog")))
+#else
+#define TLOG_FORMAT
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+    uint32_t records;       /* records accepted */
+    uint32_t dropped;       /* records lost because every buffer was busy */
+    uint32_t packets;       /* packets queued on the port */
+    uint32_t bytes;         /* payload bytes in those packets */
+} TLog_StatsTypeDef;
+
+/* Exported macro ------------------------------------------------------------*/
+/* TLOG("fmt", args...) - log a printf-style message. Arguments are integers
+   (char, int, long, enum) converted to 32 bits; %d/%i are decoded as signed,
+   %u/%x/%X/%c as unsigned. %s, floating point and 64-bit values are not
+   supported. Safe from any context; costs a few varints and a short copy
+   with interrupts disabled. */
+#define TLOG(...) \
+    do \
+    { \
+        TLOG_FORMAT static const char tlog_fmt_[] = TLOG_FMT_(__VA_ARGS__, 0); \
+        const uint32_t tlog_args_[] = { TLOG_ARGS_(__VA_ARGS__, 0) }; \
+        TLog_Write((uint32_t)tlog_fmt_, tlog_args_, \
+                   sizeof(tlog_args_) / sizeof(tlog_args_[0]) - 1U); \
+    } while (0)
+
+#define TLOG_FMT_(fmt, ...)     fmt
+#define TLOG_ARGS_(fmt, ...)    __VA_ARGS__
+
+/* Exported functions ------------------------------------------------------- */
+void TLog_Init(void);
+void TLog_Write(uint32_t token, const uint32_t *args, uint32_t count);
+void TLog_Flush(void);
+void TLog_GetStats(TLog_StatsTypeDef *stats);
+
+/* Called, possibly from interrupt context, when records are waiting for
+   TLog_Flush(); the application wakes its main loop from here */
+void TLog_ReadyCallback(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TLOG_H */
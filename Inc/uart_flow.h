@@ -0,0 +1,64 @@
+/**
+  ******************************************************************************
+  * @file    Inc/uart_flow.h
+  * @brief   Header for uart_flow.c module - USART3 RTS/CTS flow control
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_FLOW_H
+#define __UART_FLOW_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* Set to 1 to run USART3 with RTS (PB14) / CTS (PB13) hardware flow control.
+   USART6 has its RTS/CTS on port G only, which the 100-pin F407VG lacks */
+#ifndef UART_FLOW_CONTROL
+#define UART_FLOW_CONTROL 0
+#endif
+
+#define UART_FLOW_GPIO_PORT     GPIOB
+#define UART_FLOW_RTS_PIN       GPIO_PIN_14
+#define UART_FLOW_CTS_PIN       GPIO_PIN_13
+#define UART_FLOW_AF            GPIO_AF7_USART3
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+    uint32_t stalls;        /* times the peer deasserted CTS */
+    uint64_t stalled_us;    /* total time the transmitter was held by CTS */
+    uint32_t max_stall_us;  /* longest single stall */
+} UART_Flow_StatsTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+#if UART_FLOW_CONTROL
+
+void UART_Flow_Init(UART_HandleTypeDef *huart);
+void UART_Flow_IRQHandler(UART_HandleTypeDef *huart);
+bool UART_Flow_IsStalled(void);
+void UART_Flow_GetStats(UART_Flow_StatsTypeDef *stats);
+
+#define UART_FLOW_HWCONTROL     UART_HWCONTROL_RTS_CTS
+
+#else
+
+#define UART_Flow_Init(huart)           do { } while (0)
+#define UART_Flow_IRQHandler(huart)     do { } while (0)
+#define UART_Flow_IsStalled()           (false)
+
+#define UART_FLOW_HWCONTROL     UART_HWCONTROL_NONE
+
+#endif /* UART_FLOW_CONTROL */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_FLOW_H */
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * @file    Inc/uart_log.h
+  * @brief   Header for uart_log.c module - printf over the TX DMA queue
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_LOG_H
+#define __UART_LOG_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+#include <stddef.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* What UART_Log_Write() does when the ring has no room left */
+#define UART_LOG_POLICY_DROP        0   /* discard writes that do not fit whole */
+#define UART_LOG_POLICY_OVERWRITE   1   /* discard the oldest unsent lines */
+#define UART_LOG_POLICY_BLOCK       2   /* wait for the DMA to free space */
+
+#ifndef UART_LOG_POLICY
+#define UART_LOG_POLICY UART_LOG_POLICY_DROP
+#endif
+
+/* Size of the log ring, must be a power of two no larger than 32K */
+#ifndef UART_LOG_RING_SIZE
+#define UART_LOG_RING_SIZE 1024
+#endif
+
+/* Port stdout goes to */
+#ifndef UART_LOG_PORT
+#define UART_LOG_PORT UART_PORT_HC05
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+    uint32_t written;       /* bytes accepted into the ring */
+    uint32_t dropped;       /* bytes refused because the ring was full */
+    uint32_t overwritten;   /* unsent bytes discarded for newer ones */
+    uint32_t blocked;       /* writes that had to wait for the DMA */
+    uint32_t max_used;      /* high-water mark of the ring in bytes */
+} UART_Log_StatsTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+void UART_Log_Init(void);
+size_t UART_Log_Write(const char *data, size_t len);
+void UART_Log_Flush(void);
+void UART_Log_GetStats(UART_Log_StatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_LOG_H */
@@ -0,0 +1,59 @@
+/**
+  ******************************************************************************
+  * @file    Inc/uart_pool.h
+  * @brief   Header for uart_pool.c module - fixed-block TX buffer pool
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_POOL_H
+#define __UART_POOL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Number of blocks, at most 32 (one bit each in the free map) */
+#ifndef UART_POOL_BLOCKS
+#define UART_POOL_BLOCKS 8
+#endif
+
+/* Bytes per block, a multiple of 16 so every block starts on a DMA burst */
+#ifndef UART_POOL_BLOCK_SIZE
+#define UART_POOL_BLOCK_SIZE 256
+#endif
+
+#if (UART_POOL_BLOCKS < 1) || (UART_POOL_BLOCKS > 32)
+#error "UART_POOL_BLOCKS must be between 1 and 32"
+#endif
+
+#if (UART_POOL_BLOCK_SIZE % 16) != 0
+#error "UART_POOL_BLOCK_SIZE must be a multiple of 16"
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+    uint32_t allocated;     /* blocks handed out */
+    uint32_t failed;        /* allocations refused because every block was taken */
+    uint32_t in_use;        /* blocks taken right now */
+    uint32_t high_water;    /* most blocks taken at once */
+} UART_Pool_StatsTypeDef;
+
+/* Exported functions ------------------------------------------------------- */
+void UART_Pool_Init(void);
+uint8_t *UART_Pool_Alloc(void);
+void UART_Pool_Free(const uint8_t *block);
+HAL_StatusTypeDef UART_Pool_Send(UART_PortTypeDef port, uint8_t *block, uint16_t len);
+void UART_Pool_GetStats(UART_Pool_StatsTypeDef *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_POOL_H */
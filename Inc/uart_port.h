@@ -0,0 +1,105 @@
+/**
+  ******************************************************************************
+  * @file    Inc/uart_port.h
+  * @brief   Header for uart_port.c module - compile-time table of UART links
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_PORT_H
+#define __UART_PORT_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Set to 1 (e.g. from the compiler command line) to bring a link up. Pins
+   and DMA streams follow the F407 request mapping:
+     USART1  PB6/PB7   AF7  TX DMA2_Stream7 ch4  RX DMA2_Stream2 ch4
+     USART2  PA2/PA3   AF7  TX DMA1_Stream6 ch4  RX DMA1_Stream5 ch4
+     USART3  PD8/PD9   AF7  TX DMA1_Stream3 ch4  RX DMA1_Stream1 ch4
+     UART4   PC10/PC11 AF8  TX DMA1_Stream4 ch4  RX DMA1_Stream2 ch4
+     UART5   PC12/PD2  AF8  TX DMA1_Stream7 ch4  RX DMA1_Stream0 ch4
+     USART6  PC6/PC7   AF8  TX DMA2_Stream6 ch5  RX DMA2_Stream1 ch5
+   On the Discovery board PB6 also drives the audio DAC's I2C clock and
+   PC10/PC12 its I2S3 lines, so leave those links off when audio is used. */
+#ifndef UART_PORT_USE_USART1
+#define UART_PORT_USE_USART1 0
+#endif
+#ifndef UART_PORT_USE_USART2
+#define UART_PORT_USE_USART2 0
+#endif
+#ifndef UART_PORT_USE_USART3
+#define UART_PORT_USE_USART3 0
+#endif
+#ifndef UART_PORT_USE_UART4
+#define UART_PORT_USE_UART4 0
+#endif
+#ifndef UART_PORT_USE_UART5
+#define UART_PORT_USE_UART5 0
+#endif
+#ifndef UART_PORT_USE_USART6
+#define UART_PORT_USE_USART6 1
+#endif
+
+/* Rate of every link except the HC-05 one, which starts at
+   HC05_DEFAULT_BAUDRATE */
+#define UART_PORT_DEFAULT_BAUDRATE 115200
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+#if UART_PORT_USE_USART1
+    UART_PORT_USART1,
+#endif
+#if UART_PORT_USE_USART2
+    UART_PORT_USART2,
+#endif
+#if UART_PORT_USE_USART3
+    UART_PORT_USART3,
+#endif
+#if UART_PORT_USE_UART4
+    UART_PORT_UART4,
+#endif
+#if UART_PORT_USE_UART5
+    UART_PORT_UART5,
+#endif
+#if UART_PORT_USE_USART6
+    UART_PORT_USART6,
+#endif
+    UART_PORT_COUNT
+} UART_PortTypeDef;
+
+/* Link the HC-05 is wired to; reports and benchmarks go out on it too */
+#ifndef UART_PORT_HC05
+#if !UART_PORT_USE_USART6
+#error "Define UART_PORT_HC05 when USART6 is not used"
+#endif
+#define UART_PORT_HC05 UART_PORT_USART6
+#endif
+
+/* Exported variables --------------------------------------------------------*/
+extern UART_HandleTypeDef uart_port_huart[UART_PORT_COUNT];
+extern DMA_HandleTypeDef uart_port_hdmatx[UART_PORT_COUNT];
+extern DMA_HandleTypeDef uart_port_hdmarx[UART_PORT_COUNT];
+
+/* Exported macro ------------------------------------------------------------*/
+/* Handle of a port, a constant address when the port is a constant */
+#define UART_Port_Handle(port)          (&uart_port_huart[(port)])
+
+/* Port of one of the handles above, e.g. in a HAL callback */
+#define UART_Port_FromHandle(huart)     ((UART_PortTypeDef)((huart) - uart_port_huart))
+
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef UART_Port_Init(UART_PortTypeDef port, uint32_t baudrate);
+void UART_Port_TxDMA_IRQHandler(UART_PortTypeDef port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_PORT_H */
@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file    Inc/uart_rx.h
+  * @brief   Header for uart_rx.c module - circular DMA reception per UART port
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_RX_H
+#define __UART_RX_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+#include <stdbool.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* Size of the circular DMA reception buffer. The DMA raises an interrupt at
+   half and full buffer, so one span is never longer than UART_RX_BUFSIZE / 2
+   unless the USART goes idle first. */
+#define UART_RX_BUFSIZE 256
+
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef UART_RX_Start(UART_PortTypeDef port);
+HAL_StatusTypeDef UART_RX_Restart(UART_PortTypeDef port);
+void UART_RX_EventISR(UART_PortTypeDef port, uint16_t pos);
+uint32_t UART_RX_GetRestarts(UART_PortTypeDef port);
+
+/* Called from PendSV with every run of newly received bytes and the
+   Timebase_Now() of the DMA event that reported them. The span points into
+   the DMA ring and is only valid until the callback returns. */
+void UART_RX_DataCallback(UART_PortTypeDef port, const uint8_t *data, uint16_t len,
+                          uint32_t t_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_RX_H */
@@ -0,0 +1,37 @@
+/**
+  ******************************************************************************
+  * @file    Inc/uart_stream.h
+  * @brief   Header for uart_stream.c module - double-buffer TX streaming
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_STREAM_H
+#define __UART_STREAM_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+#include <stdbool.h>
+
+/* Exported functions ------------------------------------------------------- */
+HAL_StatusTypeDef UART_Stream_Start(UART_PortTypeDef port,
+                                    uint8_t *buf0, uint8_t *buf1, uint16_t len);
+HAL_StatusTypeDef UART_Stream_Stop(void);
+void UART_Stream_Submit(uint8_t idx);
+bool UART_Stream_IsRunning(UART_PortTypeDef port);
+uint32_t UART_Stream_GetUnderruns(void);
+
+/* Called from the DMA interrupt when buffer idx has been fully read and may be
+   refilled. The refilled buffer is handed back with UART_Stream_Submit(). */
+void UART_Stream_ReleasedCallback(uint8_t idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_STREAM_H */
@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    Inc/uart_tx.h
+  * @brief   Header for uart_tx.c module - queued DMA transmission per UART port
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __UART_TX_H
+#define __UART_TX_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+#include <stdbool.h>
+
+/* Exported types ------------------------------------------------------------*/
+/* TX priority classes, in increasing priority */
+typedef enum
+{
+    UART_TX_BULK = 0,
+    UART_TX_URGENT,
+    UART_TX_CLASS_COUNT
+} UART_TX_ClassTypeDef;
+
+typedef struct
+{
+    const uint8_t *data;  /* fragment start, may live in flash */
+    uint16_t len;         /* fragment length in bytes */
+} UART_TX_IovTypeDef;
+
+typedef struct
+{
+    uint32_t queued;      /* spans accepted by UART_TX_Send() */
+    uint32_t completed;   /* spans fully handed to the USART */
+    uint32_t rejected;    /* spans refused: queue full or port streaming */
+    uint32_t errors;      /* spans dropped because the DMA failed to start or run */
+    uint32_t urgent;      /* spans queued on the urgent class */
+    uint32_t preempted;   /* urgent spans sent between chunks of a bulk span */
+    uint16_t max_depth;   /* high-water mark of pending spans */
+    uint32_t done_us;     /* Timebase_Now() of the latest DMA completion */
+    uint32_t lat_max_us;  /* longest time from queueing a span to its last byte */
+    uint64_t lat_sum_us;  /* sum of that time over completed spans */
+} UART_TX_StatsTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+/* Number of pending spans per class, must be a power of two */
+#define UART_TX_QUEUE_LEN 16
+
+/* Longest DMA transfer of a bulk span, a multiple of 16 bytes. An urgent span
+   waits for at most this many byte times, 67 ms at 9600 baud. */
+#ifndef UART_TX_BULK_CHUNK
+#define UART_TX_BULK_CHUNK 64
+#endif
+
+/* Set to 1 to drive the TX DMA stream directly from its registers: one DMA
+   interrupt per span instead of the HAL's DMA TC plus USART TC pair */
+#ifndef UART_TX_FASTPATH
+#define UART_TX_FASTPATH 0
+#endif
+
+/* Set to 1 to run the TX DMA stream with its FIFO and word-wide 4-beat
+   memory bursts; DMA_Init() configures the stream accordingly */
+#ifndef UART_TX_DMA_FIFO
+#define UART_TX_DMA_FIFO 0
+#endif
+
+/* Exported functions ------------------------------------------------------- */
+void UART_TX_Init(UART_PortTypeDef port);
+HAL_StatusTypeDef UART_TX_Send(UART_PortTypeDef port, const uint8_t *data, uint16_t len);
+HAL_StatusTypeDef UART_TX_SendIov(UART_PortTypeDef port,
+                                  const UART_TX_IovTypeDef *iov, uint8_t count);
+HAL_StatusTypeDef UART_TX_SendUrgent(UART_PortTypeDef port, const uint8_t *data, uint16_t len);
+void UART_TX_CompleteISR(UART_PortTypeDef port);
+void UART_TX_ErrorISR(UART_PortTypeDef port);
+void UART_TX_DMA_IRQHandler(UART_PortTypeDef port);
+bool UART_TX_IsIdle(UART_PortTypeDef port);
+HAL_StatusTypeDef UART_TX_SetFastPath(UART_PortTypeDef port, bool enable);
+bool UART_TX_IsFastPath(UART_PortTypeDef port);
+HAL_StatusTypeDef UART_TX_Claim(UART_PortTypeDef port);
+void UART_TX_Release(UART_PortTypeDef port);
+uint32_t UART_TX_Queued(UART_PortTypeDef port);
+uint32_t UART_TX_Retired(UART_PortTypeDef port);
+uint32_t UART_TX_ClassQueued(UART_PortTypeDef port, UART_TX_ClassTypeDef cls);
+uint32_t UART_TX_ClassRetired(UART_PortTypeDef port, UART_TX_ClassTypeDef cls);
+void UART_TX_GetStats(UART_PortTypeDef port, UART_TX_StatsTypeDef *stats);
+
+/* Called from interrupt context after each span of a port has been handed
+   to the USART and the next one, if any, has been started */
+void UART_TX_CompleteCallback(UART_PortTypeDef port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UART_TX_H */
@@ -88,6 +88,23 @@ LoopFillZerobss:
   cmp  r2, r3
   bcc  FillZerobss
 
+/* Copy the .ccmram initializers from flash to CCM RAM */
+  movs  r1, #0
+  b  LoopCopyCcmInit
+
+CopyCcmInit:
+  ldr  r3, =_siccmram
+  ldr  r3, [r3, r1]
+  str  r3, [r0, r1]
+  adds  r1, r1, #4
+
+LoopCopyCcmInit:
+  ldr  r0, =_sccmram
+  ldr  r3, =_eccmram
+  adds  r2, r0, r1
+  cmp  r2, r3
+  bcc  CopyCcmInit
+
 /* Call the clock system initialization function.*/
   bl  SystemInit   
 /* Call static constructors */
@@ -0,0 +1,612 @@
+/**
+  ******************************************************************************
+  * @file    Src/accel.c
+  * @brief   LIS3DSH accelerometer telemetry: SPI1 DMA sampling, delta/varint
+  *          frames on the UART TX path.
+  *
+  *          TIM3 ticks at 1 MHz and overflows once per sample period. Its
+  *          interrupt lowers CS and starts a 7-byte SPI1 DMA transfer
+  *          (DMA2 Stream0/3, channel 3) that reads OUT_X_L..OUT_Z_H in one
+  *          burst; the completion interrupt raises CS and appends the sample
+  *          to the batch being filled. The CPU is not involved while the
+  *          bytes move, and sampling keeps its period whatever the main loop
+  *          is doing.
+  *
+  *          A full batch is handed to the main loop, which codes it as one
+  *          frame: per axis the difference to the previous sample, zigzag
+  *          mapped and written as a base-128 varint. An accelerometer at
+  *          rest or moving smoothly changes by a few counts per sample, so
+  *          most samples take 3 to 6 bytes instead of 6 raw bytes, and the
+  *          sample rate the link carries goes up by the same factor. Frames
+  *          are packets (COBS + CRC32) queued as bulk spans; a frame buffer
+  *          is reused once UART_TX_Retired() passes the span count read when
+  *          it was queued.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "accel.h"
+#include "uart_tx.h"
+#include "packet.h"
+#include "mem_sections.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+    uint32_t index;                     /* sample period of xyz[0] */
+    uint32_t period_us;                 /* sample period of the run */
+    uint32_t count;                     /* samples filled, 0 while free */
+    int16_t xyz[ACCEL_BATCH][3];
+} Accel_BatchTypeDef;
+
+typedef struct
+{
+    uint16_t hz;
+    uint8_t odr;                        /* CTRL_REG4 ODR field */
+} Accel_OdrTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define LIS3DSH_WHO_AM_I        0x0FU
+#define LIS3DSH_ID              0x3FU
+#define LIS3DSH_CTRL_REG4       0x20U
+#define LIS3DSH_CTRL_REG5       0x24U
+#define LIS3DSH_CTRL_REG6       0x25U
+#define LIS3DSH_OUT_X_L         0x28U
+#define LIS3DSH_READ            0x80U
+#define LIS3DSH_XYZ_EN          0x07U   /* CTRL_REG4: X, Y and Z enabled */
+#define LIS3DSH_BDU             0x08U   /* CTRL_REG4: block data update */
+#define LIS3DSH_ADD_INC         0x10U   /* CTRL_REG6: address auto-increment */
+
+#define ACCEL_XFER_LEN          7U      /* address, then X, Y, Z little-endian */
+#define ACCEL_HEADER_MAX        10U     /* type, 2 varints, count */
+#define ACCEL_SAMPLE_MAX        9U      /* three 17-bit zigzag deltas */
+#define ACCEL_PAYLOAD_MAX       (ACCEL_HEADER_MAX + ACCEL_BATCH * ACCEL_SAMPLE_MAX)
+#define ACCEL_FRAME_WORDS       ((PACKET_BUFSIZE(ACCEL_PAYLOAD_MAX) + 3U) / 4U)
+#define ACCEL_BATCH_MASK        (ACCEL_BATCHES - 1U)
+#define ACCEL_FRAME_MASK        (ACCEL_FRAMES - 1U)
+#define ACCEL_TIM_HZ            1000000U
+#define ACCEL_MIN_HZ            (ACCEL_TIM_HZ / 65536U + 1U)
+#define ACCEL_SPI_TIMEOUT_MS    10U
+
+#if ACCEL_PAYLOAD_MAX > PACKET_MAX_PAYLOAD
+#error "ACCEL_BATCH samples do not fit a packet"
+#endif
+#if ((ACCEL_BATCHES & ACCEL_BATCH_MASK) != 0) || ((ACCEL_FRAMES & ACCEL_FRAME_MASK) != 0)
+#error "ACCEL_BATCHES and ACCEL_FRAMES must be powers of two"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+/* Output data rates from the lowest one at or above ACCEL_MIN_HZ; TIM3 at
+   1 MHz cannot pace the 3.125, 6.25 and 12.5 Hz settings */
+static const Accel_OdrTypeDef accel_odr[] =
+{
+    { 25, 4 }, { 50, 5 }, { 100, 6 }, { 400, 7 }, { 800, 8 }, { 1600, 9 }
+};
+
+static SPI_HandleTypeDef accel_hspi;
+static DMA_HandleTypeDef accel_hdmarx;
+static DMA_HandleTypeDef accel_hdmatx;
+static TIM_HandleTypeDef accel_htim;
+DMA_BUFFER static uint8_t accel_tx[ACCEL_XFER_LEN];
+DMA_BUFFER static uint8_t accel_rx[ACCEL_XFER_LEN];
+static bool accel_present;
+static volatile bool accel_running;
+static volatile bool accel_busy;        /* SPI transfer in flight */
+static uint32_t accel_period;           /* sample periods since the start */
+static uint32_t accel_xfer_index;       /* period of the transfer in flight */
+static uint32_t accel_period_us;
+
+/* Batches, filled by the SPI completion interrupt and coded by Accel_Poll() */
+CCMRAM static Accel_BatchTypeDef accel_batch[ACCEL_BATCHES];
+static volatile uint32_t accel_batch_head;  /* batches complete */
+static volatile uint32_t accel_batch_tail;  /* batches coded */
+
+DMA_BUFFER static uint32_t accel_frame[ACCEL_FRAMES][ACCEL_FRAME_WORDS];
+static uint32_t accel_ticket[ACCEL_FRAMES];
+static uint32_t accel_frame_head;       /* frames queued */
+static uint32_t accel_frame_tail;       /* frames the DMA is done with */
+static uint8_t *accel_pending;          /* encoded frame the queue refused */
+static uint16_t accel_pending_len;
+CCMRAM static Accel_StatsTypeDef accel_stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static HAL_StatusTypeDef Accel_WriteReg(uint8_t reg, uint8_t value);
+static HAL_StatusTypeDef Accel_ReadReg(uint8_t reg, uint8_t *value);
+static void Accel_Publish(void);
+static uint16_t Accel_Encode(uint8_t *p, const Accel_BatchTypeDef *batch);
+static uint8_t *Accel_Varint(uint8_t *p, uint32_t v);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Set up SPI1, its DMA streams, TIM3 and the chip select, and check
+  *         that the LIS3DSH answers. The sensor is left powered down.
+  * @param  None
+  * @retval HAL_OK, HAL_ERROR if a peripheral fails or no LIS3DSH is found
+  */
+HAL_StatusTypeDef Accel_Init(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    uint32_t tim_clk = HAL_RCC_GetPCLK1Freq();
+    uint8_t id = 0;
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOE_CLK_ENABLE();
+    __HAL_RCC_SPI1_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    __HAL_RCC_TIM3_CLK_ENABLE();
+
+    /* Chip select, idle high */
+    HAL_GPIO_WritePin(ACCEL_CS_PORT, ACCEL_CS_PIN, GPIO_PIN_SET);
+    GPIO_InitStruct.Pin = ACCEL_CS_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(ACCEL_CS_PORT, &GPIO_InitStruct);
+
+    /* SCK, MISO, MOSI */
+    GPIO_InitStruct.Pin = GPIO_PIN_5 | GPIO_PIN_6 | GPIO_PIN_7;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    GPIO_InitStruct.Alternate = GPIO_AF5_SPI1;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    /* Mode 3, 84 MHz / 16 = 5.25 MHz, below the sensor's 10 MHz */
+    accel_hspi.Instance = SPI1;
+    accel_hspi.Init.Mode = SPI_MODE_MASTER;
+    accel_hspi.Init.Direction = SPI_DIRECTION_2LINES;
+    accel_hspi.Init.DataSize = SPI_DATASIZE_8BIT;
+    accel_hspi.Init.CLKPolarity = SPI_POLARITY_HIGH;
+    accel_hspi.Init.CLKPhase = SPI_PHASE_2EDGE;
+    accel_hspi.Init.NSS = SPI_NSS_SOFT;
+    accel_hspi.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    accel_hspi.Init.FirstBit = SPI_FIRSTBIT_MSB;
+    accel_hspi.Init.TIMode = SPI_TIMODE_DISABLE;
+    accel_hspi.Init.CRCCalculation = SPI_CRCCALCULATION_DISABLE;
+    accel_hspi.Init.CRCPolynomial = 7;
+    if (HAL_SPI_Init(&accel_hspi) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    /* SPI1_RX on DMA2 Stream0 and SPI1_TX on Stream3, channel 3; neither is
+       used by the UART port table */
+    accel_hdmarx.Instance = DMA2_Stream0;
+    accel_hdmarx.Init.Channel = DMA_CHANNEL_3;
+    accel_hdmarx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    accel_hdmarx.Init.PeriphInc = DMA_PINC_DISABLE;
+    accel_hdmarx.Init.MemInc = DMA_MINC_ENABLE;
+    accel_hdmarx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    accel_hdmarx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    accel_hdmarx.Init.Mode = DMA_NORMAL;
+    accel_hdmarx.Init.Priority = DMA_PRIORITY_HIGH;
+    accel_hdmarx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&accel_hdmarx) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    accel_hdmatx.Instance = DMA2_Stream3;
+    accel_hdmatx.Init = accel_hdmarx.Init;
+    accel_hdmatx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    accel_hdmatx.Init.Priority = DMA_PRIORITY_MEDIUM;
+    if (HAL_DMA_Init(&accel_hdmatx) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    __HAL_LINKDMA(&accel_hspi, hdmarx, accel_hdmarx);
+    __HAL_LINKDMA(&accel_hspi, hdmatx, accel_hdmatx);
+
+    HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+    HAL_NVIC_SetPriority(DMA2_Stream3_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+
+    /* Timer clocks run at twice PCLK1 when APB1 is divided */
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+    {
+        tim_clk *= 2U;
+    }
+    accel_htim.Instance = TIM3;
+    accel_htim.Init.Prescaler = tim_clk / ACCEL_TIM_HZ - 1U;
+    accel_htim.Init.CounterMode = TIM_COUNTERMODE_UP;
+    accel_htim.Init.Period = 0xFFFFU;
+    accel_htim.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    accel_htim.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    if (HAL_TIM_Base_Init(&accel_htim) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+    HAL_NVIC_SetPriority(TIM3_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(TIM3_IRQn);
+
+    /* Every sample is the same burst read */
+    accel_tx[0] = LIS3DSH_READ | LIS3DSH_OUT_X_L;
+    for (uint32_t i = 0; i < ACCEL_BATCHES; i++)
+    {
+        accel_batch[i].count = 0;
+    }
+    accel_batch_head = 0;
+    accel_batch_tail = 0;
+
+    if (Accel_ReadReg(LIS3DSH_WHO_AM_I, &id) != HAL_OK || id != LIS3DSH_ID)
+    {
+        return HAL_ERROR;
+    }
+    if (Accel_WriteReg(LIS3DSH_CTRL_REG4, 0) != HAL_OK ||
+        Accel_WriteReg(LIS3DSH_CTRL_REG5, 0) != HAL_OK ||
+        Accel_WriteReg(LIS3DSH_CTRL_REG6, LIS3DSH_ADD_INC) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    accel_present = true;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Start sampling. The sensor runs at the lowest output data rate at
+  *         or above rate_hz, TIM3 paces the reads. A running stream is
+  *         restarted at the new rate. Must be called from thread mode.
+  * @param  rate_hz: samples per second, ACCEL_MIN_HZ..ACCEL_MAX_HZ
+  * @retval HAL_OK, HAL_ERROR without a sensor or for a rate out of range
+  */
+HAL_StatusTypeDef Accel_Start(uint32_t rate_hz)
+{
+    uint8_t odr = accel_odr[sizeof(accel_odr) / sizeof(accel_odr[0]) - 1U].odr;
+
+    if (!accel_present || rate_hz < ACCEL_MIN_HZ || rate_hz > ACCEL_MAX_HZ)
+    {
+        return HAL_ERROR;
+    }
+    Accel_Stop();
+
+    for (uint32_t i = 0; i < sizeof(accel_odr) / sizeof(accel_odr[0]); i++)
+    {
+        if (accel_odr[i].hz >= rate_hz)
+        {
+            odr = accel_odr[i].odr;
+            break;
+        }
+    }
+    if (Accel_WriteReg(LIS3DSH_CTRL_REG4,
+                       (uint8_t)((odr << 4) | LIS3DSH_BDU | LIS3DSH_XYZ_EN)) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    /* Batches of an earlier run stay queued and go out with their own
+       period; the sample index starts again from 0 */
+    accel_period = 0;
+    accel_period_us = ACCEL_TIM_HZ / rate_hz;
+
+    accel_stats.rate_hz = ACCEL_TIM_HZ / accel_period_us;
+    accel_stats.samples = 0;
+    accel_stats.dropped = 0;
+    accel_stats.overruns = 0;
+    accel_stats.frames = 0;
+    accel_stats.bytes = 0;
+
+    __HAL_TIM_SET_AUTORELOAD(&accel_htim, accel_period_us - 1U);
+    __HAL_TIM_SET_COUNTER(&accel_htim, 0);
+    accel_running = true;
+    return HAL_TIM_Base_Start_IT(&accel_htim);
+}
+
+/**
+  * @brief  Stop sampling and power the sensor down. The batch being filled
+  *         is handed to Accel_Poll() so the last samples still go out. Must
+  *         be called from thread mode.
+  * @param  None
+  * @retval None
+  */
+void Accel_Stop(void)
+{
+    uint32_t start = HAL_GetTick();
+
+    if (!accel_running)
+    {
+        return;
+    }
+    HAL_TIM_Base_Stop_IT(&accel_htim);
+    accel_running = false;
+
+    /* The read in flight takes a few microseconds */
+    while (accel_busy && (HAL_GetTick() - start) < ACCEL_SPI_TIMEOUT_MS)
+    {
+    }
+
+    if (accel_batch_head - accel_batch_tail < ACCEL_BATCHES &&
+        accel_batch[accel_batch_head & ACCEL_BATCH_MASK].count != 0)
+    {
+        Accel_Publish();
+    }
+    (void)Accel_WriteReg(LIS3DSH_CTRL_REG4, 0);
+}
+
+/**
+  * @brief  Report whether sampling is running
+  * @param  None
+  * @retval true while sampling
+  */
+bool Accel_IsRunning(void)
+{
+    return accel_running;
+}
+
+/**
+  * @brief  Take back the frames the DMA has sent and code and queue the
+  *         batches that are complete. Must be called from thread mode.
+  * @param  None
+  * @retval None
+  */
+void Accel_Poll(void)
+{
+    uint32_t retired = UART_TX_Retired(ACCEL_PORT);
+
+    while (accel_frame_tail != accel_frame_head &&
+           (int32_t)(retired - accel_ticket[accel_frame_tail & ACCEL_FRAME_MASK]) >= 0)
+    {
+        accel_frame_tail++;
+    }
+
+    while (accel_frame_head - accel_frame_tail < ACCEL_FRAMES)
+    {
+        uint8_t *buf = (uint8_t *)accel_frame[accel_frame_head & ACCEL_FRAME_MASK];
+
+        /* Encoding works in place, a refused frame is kept for the next poll */
+        if (accel_pending == NULL)
+        {
+            Accel_BatchTypeDef *batch = &accel_batch[accel_batch_tail & ACCEL_BATCH_MASK];
+            uint16_t len;
+
+            if (accel_batch_tail == accel_batch_head)
+            {
+                break;
+            }
+            len = Accel_Encode(PACKET_PAYLOAD(buf), batch);
+
+            /* Give the batch back to the sampling interrupt */
+            batch->count = 0;
+            __DMB();
+            accel_batch_tail++;
+
+            accel_pending_len = Packet_Encode(buf, len, &accel_pending);
+        }
+        if (UART_TX_Send(ACCEL_PORT, accel_pending, accel_pending_len) != HAL_OK)
+        {
+            break;
+        }
+
+        accel_ticket[accel_frame_head & ACCEL_FRAME_MASK] = UART_TX_Queued(ACCEL_PORT);
+        accel_frame_head++;
+        accel_stats.frames++;
+        accel_stats.bytes += accel_pending_len;
+        accel_pending = NULL;
+    }
+}
+
+/**
+  * @brief  Copy the telemetry counters
+  * @param  stats: destination
+  * @retval None
+  */
+void Accel_GetStats(Accel_StatsTypeDef *stats)
+{
+    *stats = accel_stats;
+}
+
+/**
+  * @brief  TIM3 update: start the read of one sample
+  * @param  None
+  * @retval None
+  */
+void Accel_TIM_IRQHandler(void)
+{
+    uint32_t index;
+
+    if (__HAL_TIM_GET_FLAG(&accel_htim, TIM_FLAG_UPDATE) == RESET)
+    {
+        return;
+    }
+    __HAL_TIM_CLEAR_FLAG(&accel_htim, TIM_FLAG_UPDATE);
+
+    index = accel_period++;
+    if (accel_busy)
+    {
+        accel_stats.overruns++;
+        return;
+    }
+
+    accel_busy = true;
+    accel_xfer_index = index;
+    HAL_GPIO_WritePin(ACCEL_CS_PORT, ACCEL_CS_PIN, GPIO_PIN_RESET);
+    if (HAL_SPI_TransmitReceive_DMA(&accel_hspi, accel_tx, accel_rx, ACCEL_XFER_LEN) != HAL_OK)
+    {
+        HAL_GPIO_WritePin(ACCEL_CS_PORT, ACCEL_CS_PIN, GPIO_PIN_SET);
+        accel_busy = false;
+        accel_stats.overruns++;
+    }
+}
+
+/**
+  * @brief  SPI transfer finished, from HAL_SPI_TxRxCpltCallback() or
+  *         HAL_SPI_ErrorCallback(): store the sample if the read succeeded
+  * @param  hspi: SPI handle of the callback
+  * @retval None
+  */
+void Accel_TransferCompleteISR(SPI_HandleTypeDef *hspi)
+{
+    Accel_BatchTypeDef *batch;
+    uint32_t n;
+
+    if (hspi != &accel_hspi)
+    {
+        return;
+    }
+    HAL_GPIO_WritePin(ACCEL_CS_PORT, ACCEL_CS_PIN, GPIO_PIN_SET);
+    accel_busy = false;
+    if (hspi->ErrorCode != HAL_SPI_ERROR_NONE)
+    {
+        accel_stats.overruns++;
+        return;
+    }
+
+    /* A skipped period ends the batch, so samples of a frame are always
+       consecutive */
+    batch = &accel_batch[accel_batch_head & ACCEL_BATCH_MASK];
+    if (accel_batch_head - accel_batch_tail < ACCEL_BATCHES && batch->count != 0 &&
+        accel_xfer_index != batch->index + batch->count)
+    {
+        Accel_Publish();
+        batch = &accel_batch[accel_batch_head & ACCEL_BATCH_MASK];
+    }
+    if (accel_batch_head - accel_batch_tail >= ACCEL_BATCHES)
+    {
+        accel_stats.dropped++;
+        return;
+    }
+
+    n = batch->count;
+    if (n == 0)
+    {
+        batch->index = accel_xfer_index;
+        batch->period_us = accel_period_us;
+    }
+    batch->xyz[n][0] = (int16_t)(accel_rx[1] | (accel_rx[2] << 8));
+    batch->xyz[n][1] = (int16_t)(accel_rx[3] | (accel_rx[4] << 8));
+    batch->xyz[n][2] = (int16_t)(accel_rx[5] | (accel_rx[6] << 8));
+    batch->count = n + 1U;
+    accel_stats.samples++;
+
+    if (batch->count == ACCEL_BATCH)
+    {
+        Accel_Publish();
+    }
+}
+
+/**
+  * @brief  SPI1 RX DMA stream interrupt
+  * @param  None
+  * @retval None
+  */
+void Accel_DMA_RX_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&accel_hdmarx);
+}
+
+/**
+  * @brief  SPI1 TX DMA stream interrupt
+  * @param  None
+  * @retval None
+  */
+void Accel_DMA_TX_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&accel_hdmatx);
+}
+
+/**
+  * @brief  Batch ready callback, overridden by the application
+  * @param  None
+  * @retval None
+  */
+__weak void Accel_ReadyCallback(void)
+{
+}
+
+/**
+  * @brief  Hand the batch at head to Accel_Poll()
+  * @param  None
+  * @retval None
+  */
+static void Accel_Publish(void)
+{
+    __DMB();
+    accel_batch_head++;
+    Accel_ReadyCallback();
+}
+
+/**
+  * @brief  Code one batch as a frame payload
+  * @param  p: destination, ACCEL_PAYLOAD_MAX bytes
+  * @param  batch: complete batch
+  * @retval Payload length
+  */
+static uint16_t Accel_Encode(uint8_t *p, const Accel_BatchTypeDef *batch)
+{
+    uint8_t *start = p;
+    int32_t prev[3] = { 0, 0, 0 };
+
+    *p++ = ACCEL_FRAME_TYPE;
+    p = Accel_Varint(p, batch->index);
+    p = Accel_Varint(p, batch->period_us);
+    *p++ = (uint8_t)batch->count;
+
+    for (uint32_t i = 0; i < batch->count; i++)
+    {
+        for (uint32_t axis = 0; axis < 3U; axis++)
+        {
+            int32_t delta = (int32_t)batch->xyz[i][axis] - prev[axis];
+
+            /* Zigzag: small negative and positive deltas both code short */
+            p = Accel_Varint(p, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+            prev[axis] = batch->xyz[i][axis];
+        }
+    }
+
+    return (uint16_t)(p - start);
+}
+
+/**
+  * @brief  Write v as a little-endian base-128 varint
+  * @param  p: destination, room for 5 bytes
+  * @param  v: value
+  * @retval Pointer past the last byte written
+  */
+static uint8_t *Accel_Varint(uint8_t *p, uint32_t v)
+{
+    while (v >= 0x80U)
+    {
+        *p++ = (uint8_t)(v | 0x80U);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+/**
+  * @brief  Write one LIS3DSH register
+  * @param  reg: register address
+  * @param  value: new value
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef Accel_WriteReg(uint8_t reg, uint8_t value)
+{
+    uint8_t tx[2] = { reg, value };
+    HAL_StatusTypeDef status;
+
+    HAL_GPIO_WritePin(ACCEL_CS_PORT, ACCEL_CS_PIN, GPIO_PIN_RESET);
+    status = HAL_SPI_Transmit(&accel_hspi, tx, sizeof(tx), ACCEL_SPI_TIMEOUT_MS);
+    HAL_GPIO_WritePin(ACCEL_CS_PORT, ACCEL_CS_PIN, GPIO_PIN_SET);
+    return status;
+}
+
+/**
+  * @brief  Read one LIS3DSH register
+  * @param  reg: register address
+  * @param  value: destination
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef Accel_ReadReg(uint8_t reg, uint8_t *value)
+{
+    uint8_t tx[2] = { (uint8_t)(LIS3DSH_READ | reg), 0 };
+    uint8_t rx[2] = { 0, 0 };
+    HAL_StatusTypeDef status;
+
+    HAL_GPIO_WritePin(ACCEL_CS_PORT, ACCEL_CS_PIN, GPIO_PIN_RESET);
+    status = HAL_SPI_TransmitReceive(&accel_hspi, tx, rx, sizeof(tx), ACCEL_SPI_TIMEOUT_MS);
+    HAL_GPIO_WritePin(ACCEL_CS_PORT, ACCEL_CS_PIN, GPIO_PIN_SET);
+    *value = rx[1];
+    return status;
+}
@@ -0,0 +1,587 @@
+/**
+  ******************************************************************************
+  * @file    Src/bench.c
+  * @brief   On-target link benchmarks, run from thread mode.
+  *
+  *          Timings use the DWT cycle counter, so results are in CPU cycles
+  *          converted with SystemCoreClock; frame time stamps come from the
+  *          microsecond time base. Reports are queued as text on the
+  *          TX path once the link is back at its original rate.
+  *
+  *          The frame stream is not a blocking run: BENCH_StreamPoll() is
+  *          called from the main loop on every TX completion and keeps
+  *          BENCH_FRAMES sequence-numbered, time-stamped frames queued, so
+  *          the DMA always has the next one chained. A frame buffer is
+  *          rewritten once UART_TX_Retired() passes the span count read when
+  *          it was queued.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "bench.h"
+#include "hc05.h"
+#include "uart_tx.h"
+#include "packet.h"
+#include "timebase.h"
+#include "mem_sections.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define BENCH_PATTERN_SIZE  256
+#define BENCH_REPORT_SIZE   512
+#define BENCH_COPY_SIZE     4096
+#define BENCH_FRAME_WORDS   ((PACKET_BUFSIZE(BENCH_FRAME_PAYLOAD) + 3U) / 4U)
+#define BENCH_FRAME_MASK    (BENCH_FRAMES - 1U)
+
+/* A thread-mode loop iteration is far shorter than this; a longer gap
+   between two cycle counter reads was spent in an interrupt */
+#define BENCH_GAP_CYCLES    64U
+
+#if BENCH_FRAME_PAYLOAD > PACKET_MAX_PAYLOAD || BENCH_FRAME_PAYLOAD < BENCH_FRAME_HEADER
+#error "BENCH_FRAME_PAYLOAD must hold the frame header and fit a packet"
+#endif
+#if (BENCH_FRAMES & (BENCH_FRAMES - 1)) != 0
+#error "BENCH_FRAMES must be a power of two"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+DMA_BUFFER static uint8_t bench_pattern[BENCH_PATTERN_SIZE];
+DMA_BUFFER static char bench_report[BENCH_REPORT_SIZE];
+static uint32_t bench_copy_src[BENCH_COPY_SIZE / 4];
+static uint32_t bench_copy_dst[BENCH_COPY_SIZE / 4];
+
+DMA_BUFFER static uint32_t bench_frame[BENCH_FRAMES][BENCH_FRAME_WORDS];
+static uint32_t bench_ticket[BENCH_FRAMES];
+static uint32_t bench_head;             /* frames queued */
+static uint32_t bench_tail;             /* frames the DMA is done with */
+static uint8_t *bench_pending;          /* encoded frame the queue refused */
+static uint16_t bench_pending_len;
+static uint32_t bench_seq;
+static uint32_t bench_start;
+static uint32_t bench_start_us;         /* frame time stamps are relative to it */
+static uint32_t bench_duration;
+static bool bench_running;
+static BENCH_StreamStatsTypeDef bench_stream;
+
+/* Private function prototypes -----------------------------------------------*/
+static void BENCH_CycleCounterStart(void);
+static uint32_t BENCH_SendTimed(uint32_t bytes);
+static uint32_t BENCH_CopyLoop(void);
+static uint32_t BENCH_TxCostRun(uint32_t *max_gap);
+static uint32_t BENCH_StolenCycles(uint32_t window, uint32_t *elapsed, uint32_t *max_gap);
+static void BENCH_FrameFill(uint8_t *payload, uint32_t seq);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Measure the TX throughput at every rate the HC-05 supports
+  *         and report bytes/s for each. This is the rate at which USART6
+  *         takes bytes from the MCU; the module restarts at each rate and
+  *         nothing is connected over the air meanwhile, so what the radio
+  *         link carries is not measured.
+  * @param  None
+  * @retval HAL status of queueing the report
+  */
+HAL_StatusTypeDef BENCH_BaudSweep(void)
+{
+    uint32_t old = HC05_GetBaudRate();
+    uint32_t result[16];
+    uint32_t count = hc05_baudrate_count;
+    int len;
+
+    if (count > sizeof(result) / sizeof(result[0]))
+    {
+        count = sizeof(result) / sizeof(result[0]);
+    }
+
+    BENCH_CycleCounterStart();
+    for (uint32_t i = 0; i < BENCH_PATTERN_SIZE; i++)
+    {
+        bench_pattern[i] = (uint8_t)i;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t baud = hc05_baudrates[i];
+        uint32_t bytes = (baud / 10U) * BENCH_SWEEP_MS / 1000U;
+        uint32_t cycles;
+
+        result[i] = 0;
+        if (HC05_SetBaudRate(baud) != HAL_OK && baud != HC05_GetBaudRate())
+        {
+            continue;
+        }
+        cycles = BENCH_SendTimed(bytes);
+        if (cycles != 0)
+        {
+            result[i] = (uint32_t)(((uint64_t)bytes * SystemCoreClock) / cycles);
+        }
+    }
+
+    HC05_SetBaudRate(old);
+    HAL_Delay(BENCH_SWEEP_RECONNECT_MS);
+
+    len = snprintf(bench_report, sizeof(bench_report), "baud sweep, MCU side (bytes/s)\r\n");
+    for (uint32_t i = 0; i < count && len < BENCH_REPORT_SIZE; i++)
+    {
+        len += snprintf(&bench_report[len], sizeof(bench_report) - len, "%8lu %8lu%s\r\n",
+                        (unsigned long)hc05_baudrates[i], (unsigned long)result[i],
+                        result[i] == 0 ? " (rate refused)" : "");
+    }
+    if (len > BENCH_REPORT_SIZE - 1)
+    {
+        len = BENCH_REPORT_SIZE - 1;
+    }
+
+    return UART_TX_Send(UART_PORT_HC05, (const uint8_t *)bench_report, (uint16_t)len);
+}
+
+/**
+  * @brief  Measure how much a memory-heavy CPU loop slows down while the TX
+  *         DMA reads SRAM, for the DMA mode this firmware was built with
+  *         (byte-wide direct mode, or FIFO with word bursts when
+  *         UART_TX_DMA_FIFO is set). Runs at the fastest rate the HC-05
+  *         accepts and refuses if none reaches BENCH_CONTENTION_MIN_BAUD.
+  * @param  None
+  * @retval HAL status of queueing the report
+  */
+HAL_StatusTypeDef BENCH_BusContention(void)
+{
+    uint32_t old = HC05_GetBaudRate();
+    uint32_t baud = old;
+    uint32_t idle;
+    uint32_t busy;
+    uint32_t queued = 0;
+    bool drained;
+    int len;
+
+    /* The fastest supported rate first, down to the minimum */
+    for (uint32_t i = hc05_baudrate_count; i-- > 0; )
+    {
+        if (hc05_baudrates[i] < BENCH_CONTENTION_MIN_BAUD)
+        {
+            break;
+        }
+        if (hc05_baudrates[i] <= old || HC05_SetBaudRate(hc05_baudrates[i]) == HAL_OK)
+        {
+            baud = HC05_GetBaudRate();
+            break;
+        }
+    }
+    if (baud < BENCH_CONTENTION_MIN_BAUD)
+    {
+        len = snprintf(bench_report, sizeof(bench_report),
+                       "bus contention refused: HC-05 accepts no rate from %lu baud\r\n",
+                       (unsigned long)BENCH_CONTENTION_MIN_BAUD);
+        return UART_TX_Send(UART_PORT_HC05, (const uint8_t *)bench_report, (uint16_t)len);
+    }
+
+    BENCH_CycleCounterStart();
+    for (uint32_t i = 0; i < BENCH_PATTERN_SIZE; i++)
+    {
+        bench_pattern[i] = (uint8_t)i;
+    }
+    while (!UART_TX_IsIdle(UART_PORT_HC05))
+    {
+    }
+
+    idle = BENCH_CopyLoop();
+
+    /* Fill the queue so the DMA is busy for the whole loop */
+    while (UART_TX_Send(UART_PORT_HC05, bench_pattern, BENCH_PATTERN_SIZE) == HAL_OK)
+    {
+        queued += BENCH_PATTERN_SIZE;
+    }
+    busy = BENCH_CopyLoop();
+    drained = UART_TX_IsIdle(UART_PORT_HC05);
+    while (!UART_TX_IsIdle(UART_PORT_HC05))
+    {
+    }
+
+    if (baud != old)
+    {
+        HC05_SetBaudRate(old);
+        HAL_Delay(BENCH_SWEEP_RECONNECT_MS);
+    }
+
+    len = snprintf(bench_report, sizeof(bench_report),
+                   "bus contention (%s, %lu baud, %lu bytes queued)\r\n"
+                   "  dma idle %lu cycles\r\n  dma busy %lu cycles\r\n  slowdown %ld ppm%s\r\n",
+                   UART_TX_DMA_FIFO ? "fifo word burst" : "direct byte",
+                   (unsigned long)baud, (unsigned long)queued,
+                   (unsigned long)idle, (unsigned long)busy,
+                   (long)(((int64_t)busy - (int64_t)idle) * 1000000 / (int64_t)idle),
+                   drained ? " (queue drained early)" : "");
+    if (len > BENCH_REPORT_SIZE - 1)
+    {
+        len = BENCH_REPORT_SIZE - 1;
+    }
+
+    return UART_TX_Send(UART_PORT_HC05, (const uint8_t *)bench_report, (uint16_t)len);
+}
+
+/**
+  * @brief  Measure the interrupt cycles each queued span costs on the HAL
+  *         path and, when built in, on the register-level fast path. Run
+  *         with the frame and accelerometer streams stopped.
+  * @param  None
+  * @retval HAL status of queueing the report
+  */
+HAL_StatusTypeDef BENCH_TxCost(void)
+{
+    bool fast = UART_TX_IsFastPath(UART_PORT_HC05);
+    uint32_t cost[2] = { 0, 0 };
+    uint32_t max_gap[2] = { 0, 0 };
+    int len;
+
+    BENCH_CycleCounterStart();
+    for (uint32_t path = 0; path < (UART_TX_FASTPATH ? 2U : 1U); path++)
+    {
+        while (UART_TX_SetFastPath(UART_PORT_HC05, path != 0U) == HAL_BUSY)
+        {
+        }
+        cost[path] = BENCH_TxCostRun(&max_gap[path]);
+    }
+    while (UART_TX_SetFastPath(UART_PORT_HC05, fast) == HAL_BUSY)
+    {
+    }
+
+    len = snprintf(bench_report, sizeof(bench_report),
+                   "tx interrupt cycles per span (%u x %u spans of 1 byte, %lu baud)\r\n"
+                   "  hal  %lu, longest interrupt %lu\r\n",
+                   BENCH_COST_ROUNDS, UART_TX_QUEUE_LEN, (unsigned long)HC05_GetBaudRate(),
+                   (unsigned long)cost[0], (unsigned long)max_gap[0]);
+    if (UART_TX_FASTPATH)
+    {
+        len += snprintf(&bench_report[len], sizeof(bench_report) - len,
+                        "  fast %lu, longest interrupt %lu\r\n",
+                        (unsigned long)cost[1], (unsigned long)max_gap[1]);
+    }
+    else
+    {
+        len += snprintf(&bench_report[len], sizeof(bench_report) - len,
+                        "  fast not built in (UART_TX_FASTPATH=0)\r\n");
+    }
+    if (len > BENCH_REPORT_SIZE - 1)
+    {
+        len = BENCH_REPORT_SIZE - 1;
+    }
+
+    return UART_TX_Send(UART_PORT_HC05, (const uint8_t *)bench_report, (uint16_t)len);
+}
+
+/**
+  * @brief  Start streaming pattern frames on the HC-05 link as fast as it
+  *         takes them. Must be called from thread mode.
+  * @param  duration_ms: run time, 0 for BENCH_STREAM_MS
+  * @retval None
+  */
+void BENCH_StreamStart(uint32_t duration_ms)
+{
+    if (bench_running)
+    {
+        return;
+    }
+
+    bench_start_us = Timebase_Now();
+
+    /* Frames of an earlier run still on the wire keep their buffers until
+       they retire; a frame that was never queued is dropped */
+    bench_pending = NULL;
+    bench_seq = 0;
+    memset(&bench_stream, 0, sizeof(bench_stream));
+    bench_stream.baud = HC05_GetBaudRate();
+    bench_duration = (duration_ms != 0) ? duration_ms : BENCH_STREAM_MS;
+    bench_start = HAL_GetTick();
+    bench_running = true;
+
+    BENCH_StreamPoll();
+}
+
+/**
+  * @brief  End the stream and print its counters. Frames already queued
+  *         still go out. Must be called from thread mode.
+  * @param  None
+  * @retval None
+  */
+void BENCH_StreamStop(void)
+{
+    uint32_t ms;
+    uint32_t line_permille = 0;
+
+    if (!bench_running)
+    {
+        return;
+    }
+    bench_running = false;
+    bench_stream.elapsed_ms = HAL_GetTick() - bench_start;
+
+    /* Share of the line time the frames occupy, 10 bits per byte */
+    ms = (bench_stream.elapsed_ms != 0) ? bench_stream.elapsed_ms : 1U;
+    if (bench_stream.baud != 0)
+    {
+        line_permille = (uint32_t)((uint64_t)bench_stream.bytes * 10U * 1000U * 1000U /
+                                   ((uint64_t)bench_stream.baud * ms));
+    }
+
+    printf("\r\nstream %lu frames %lu bytes in %lu ms: %lu B/s %lu frames/s "
+           "line %lu.%lu%% starved %lu\r\n",
+           (unsigned long)bench_stream.frames, (unsigned long)bench_stream.bytes,
+           (unsigned long)bench_stream.elapsed_ms,
+           (unsigned long)((uint64_t)bench_stream.bytes * 1000U / ms),
+           (unsigned long)((uint64_t)bench_stream.frames * 1000U / ms),
+           (unsigned long)(line_permille / 10U), (unsigned long)(line_permille % 10U),
+           (unsigned long)bench_stream.starved);
+}
+
+/**
+  * @brief  Report whether the frame stream is running
+  * @param  None
+  * @retval true while streaming
+  */
+bool BENCH_StreamIsRunning(void)
+{
+    return bench_running;
+}
+
+/**
+  * @brief  Take back the frames the DMA has sent and queue new ones until
+  *         BENCH_FRAMES are in flight; ends the run when its time is up.
+  *         Must be called from thread mode.
+  * @param  None
+  * @retval None
+  */
+void BENCH_StreamPoll(void)
+{
+    uint32_t retired;
+
+    if (!bench_running)
+    {
+        return;
+    }
+    if (HAL_GetTick() - bench_start >= bench_duration)
+    {
+        BENCH_StreamStop();
+        return;
+    }
+
+    retired = UART_TX_Retired(UART_PORT_HC05);
+    while (bench_tail != bench_head &&
+           (int32_t)(retired - bench_ticket[bench_tail & BENCH_FRAME_MASK]) >= 0)
+    {
+        bench_tail++;
+    }
+
+    /* The line went idle between two polls */
+    if (bench_stream.frames != 0 && UART_TX_IsIdle(UART_PORT_HC05))
+    {
+        bench_stream.starved++;
+    }
+
+    while (bench_head - bench_tail < BENCH_FRAMES)
+    {
+        uint8_t *buf = (uint8_t *)bench_frame[bench_head & BENCH_FRAME_MASK];
+
+        /* Encoding works in place, a refused frame is kept for the next poll */
+        if (bench_pending == NULL)
+        {
+            BENCH_FrameFill(PACKET_PAYLOAD(buf), bench_seq);
+            bench_pending_len = Packet_Encode(buf, BENCH_FRAME_PAYLOAD, &bench_pending);
+        }
+        if (UART_TX_Send(UART_PORT_HC05, bench_pending, bench_pending_len) != HAL_OK)
+        {
+            break;
+        }
+
+        bench_ticket[bench_head & BENCH_FRAME_MASK] = UART_TX_Queued(UART_PORT_HC05);
+        bench_head++;
+        bench_seq++;
+        bench_stream.frames++;
+        bench_stream.bytes += bench_pending_len;
+        bench_pending = NULL;
+    }
+}
+
+/**
+  * @brief  Copy the stream counters
+  * @param  stats: destination
+  * @retval None
+  */
+void BENCH_StreamGetStats(BENCH_StreamStatsTypeDef *stats)
+{
+    *stats = bench_stream;
+    if (bench_running)
+    {
+        stats->elapsed_ms = HAL_GetTick() - bench_start;
+    }
+}
+
+/**
+  * @brief  Enable the DWT cycle counter
+  * @param  None
+  * @retval None
+  */
+static void BENCH_CycleCounterStart(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+  * @brief  Push a number of pattern bytes through the TX queue and time it
+  *         from the first queued span to the last completion
+  * @param  bytes: amount of data to send
+  * @retval Elapsed CPU cycles
+  */
+static uint32_t BENCH_SendTimed(uint32_t bytes)
+{
+    uint32_t start;
+
+    while (!UART_TX_IsIdle(UART_PORT_HC05))
+    {
+    }
+
+    start = DWT->CYCCNT;
+    while (bytes > 0)
+    {
+        uint16_t chunk = (bytes > BENCH_PATTERN_SIZE) ? BENCH_PATTERN_SIZE : (uint16_t)bytes;
+
+        /* Keep the queue topped up, spans are chained from the interrupt */
+        if (UART_TX_Send(UART_PORT_HC05, bench_pattern, chunk) == HAL_OK)
+        {
+            bytes -= chunk;
+        }
+    }
+    while (!UART_TX_IsIdle(UART_PORT_HC05))
+    {
+    }
+
+    return DWT->CYCCNT - start;
+}
+
+/**
+  * @brief  Send rounds of one-byte spans on the current TX path and work out
+  *         the interrupt cycles per span, net of what the idle firmware
+  *         spends in interrupts (SysTick, PendSV work of other modules)
+  * @param  max_gap: longest single interrupt seen, updated
+  * @retval Cycles per completed span
+  */
+static uint32_t BENCH_TxCostRun(uint32_t *max_gap)
+{
+    UART_TX_StatsTypeDef stats;
+    uint32_t idle_gap = 0;
+    uint32_t idle_elapsed;
+    uint32_t idle_stolen;
+    uint32_t elapsed;
+    uint64_t busy_elapsed = 0;
+    uint64_t busy_stolen = 0;
+    uint64_t background;
+    uint32_t spans = 0;
+
+    idle_stolen = BENCH_StolenCycles(SystemCoreClock / 10U, &idle_elapsed, &idle_gap);
+
+    for (uint32_t round = 0; round < BENCH_COST_ROUNDS; round++)
+    {
+        uint32_t done;
+
+        while (UART_TX_Send(UART_PORT_HC05, bench_pattern, 1) == HAL_OK)
+        {
+        }
+        /* Spans that finish while the queue is filled are not counted */
+        UART_TX_GetStats(UART_PORT_HC05, &stats);
+        done = stats.completed;
+        busy_stolen += BENCH_StolenCycles(0, &elapsed, max_gap);
+        busy_elapsed += elapsed;
+        UART_TX_GetStats(UART_PORT_HC05, &stats);
+        spans += stats.completed - done;
+    }
+
+    background = (uint64_t)idle_stolen * busy_elapsed / idle_elapsed;
+    if (spans == 0 || busy_stolen <= background)
+    {
+        return 0;
+    }
+    return (uint32_t)((busy_stolen - background) / spans);
+}
+
+/**
+  * @brief  Spin in thread mode and add up the cycles interrupts took away,
+  *         seen as gaps between consecutive cycle counter reads
+  * @param  window: cycles to run for, 0 to run until the TX queue is idle
+  * @param  elapsed: cycles actually run
+  * @param  max_gap: longest single gap, updated
+  * @retval Cycles spent in interrupts
+  */
+static uint32_t BENCH_StolenCycles(uint32_t window, uint32_t *elapsed, uint32_t *max_gap)
+{
+    uint32_t start = DWT->CYCCNT;
+    uint32_t last = start;
+    uint32_t stolen = 0;
+
+    for (;;)
+    {
+        uint32_t now = DWT->CYCCNT;
+        uint32_t gap = now - last;
+
+        if (gap > BENCH_GAP_CYCLES)
+        {
+            stolen += gap;
+            if (gap > *max_gap)
+            {
+                *max_gap = gap;
+            }
+        }
+        last = now;
+        if ((window != 0U) ? (now - start >= window) : UART_TX_IsIdle(UART_PORT_HC05))
+        {
+            break;
+        }
+    }
+
+    *elapsed = last - start;
+    return stolen;
+}
+
+/**
+  * @brief  Time BENCH_COPY_PASSES copies of a 4 KiB SRAM block
+  * @param  None
+  * @retval Elapsed CPU cycles
+  */
+static uint32_t BENCH_CopyLoop(void)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    for (uint32_t pass = 0; pass < BENCH_COPY_PASSES; pass++)
+    {
+        memcpy(bench_copy_dst, bench_copy_src, sizeof(bench_copy_dst));
+        bench_copy_src[pass & (BENCH_COPY_SIZE / 4 - 1)] ^= pass;
+    }
+
+    return DWT->CYCCNT - start;
+}
+
+/**
+  * @brief  Write the payload of one stream frame
+  * @param  payload: BENCH_FRAME_PAYLOAD bytes
+  * @param  seq: sequence number
+  * @retval None
+  */
+static void BENCH_FrameFill(uint8_t *payload, uint32_t seq)
+{
+    uint32_t t = Timebase_Since(bench_start_us);
+
+    payload[0] = BENCH_FRAME_TYPE;
+    payload[1] = (uint8_t)seq;
+    payload[2] = (uint8_t)(seq >> 8);
+    payload[3] = (uint8_t)(seq >> 16);
+    payload[4] = (uint8_t)(seq >> 24);
+    payload[5] = (uint8_t)t;
+    payload[6] = (uint8_t)(t >> 8);
+    payload[7] = (uint8_t)(t >> 16);
+    payload[8] = (uint8_t)(t >> 24);
+    for (uint32_t i = 0; i < BENCH_FRAME_PAYLOAD - BENCH_FRAME_HEADER; i++)
+    {
+        payload[BENCH_FRAME_HEADER + i] = (uint8_t)(seq + i);
+    }
+}
@@ -0,0 +1,196 @@
+/**
+  ******************************************************************************
+  * @file    Src/cmd.c
+  * @brief   Line commands parsed straight out of the received data.
+  *
+  *          A command is a line "name [argument]" ended by CR or LF. Lines
+  *          that lie whole inside one span handed over by the RX ring are
+  *          parsed where they are: the name is looked up and the handler gets
+  *          a pointer to the argument inside the ring. Only a line split
+  *          across two spans (a DMA wrap or an IDLE event in the middle of
+  *          typing) is gathered in the parser's carry buffer first.
+  *
+  *          The name is looked up with a perfect hash over its first and last
+  *          characters and its length, generated by tools/cmd_phash.py, so
+  *          a lookup is one table read and one compare whatever the number
+  *          of commands.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cmd.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define CMD_HASH(name, len) \
+    (((uint8_t)(name)[0] * CMD_HASH_A + (uint8_t)(name)[(len) - 1U] * CMD_HASH_B + (len)) & \
+     (CMD_HASH_SIZE - 1U))
+
+/* Private variables ---------------------------------------------------------*/
+/* Slots from tools/cmd_phash.py, empty slots have len 0 */
+static const Cmd_EntryTypeDef cmd_table[CMD_HASH_SIZE] =
+{
+    [ 0] = { "stream", 6, Cmd_OnStream },
+    [ 4] = { "events", 6, Cmd_OnEvents },
+    [ 5] = { "msg",    3, Cmd_OnMsg },
+    [ 6] = { "prof",   4, Cmd_OnProf },
+    [ 8] = { "sweep",  5, Cmd_OnSweep },
+    [ 9] = { "B",      1, Cmd_OnSweep },
+    [10] = { "accel",  5, Cmd_OnAccel },
+    [13] = { "C",      1, Cmd_OnBench },
+    [17] = { "stats",  5, Cmd_OnStats },
+    [18] = { "baud",   4, Cmd_OnBaud },
+    [21] = { "E",      1, Cmd_OnEvents },
+    [22] = { "txcost", 6, Cmd_OnTxCost },
+    [28] = { "help",   4, Cmd_OnHelp },
+    [29] = { "?",      1, Cmd_OnProf },
+    [31] = { "bench",  5, Cmd_OnBench },
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void Cmd_Line(Cmd_ParserTypeDef *parser, const char *line, uint16_t len);
+static const uint8_t *Cmd_FindEol(const uint8_t *p, const uint8_t *end);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Reset a parser
+  * @param  parser: parser state
+  * @retval None
+  */
+void Cmd_Init(Cmd_ParserTypeDef *parser)
+{
+    memset(parser, 0, sizeof(*parser));
+}
+
+/**
+  * @brief  Parse received bytes and run the commands they complete
+  * @param  parser: state of the stream the bytes belong to
+  * @param  data: received bytes, only read during the call
+  * @param  len: number of bytes
+  * @retval None
+  */
+void Cmd_Feed(Cmd_ParserTypeDef *parser, const uint8_t *data, uint16_t len)
+{
+    const uint8_t *p = data;
+    const uint8_t *end = data + len;
+
+    while (p < end)
+    {
+        const uint8_t *eol = Cmd_FindEol(p, end);
+        uint16_t n = (uint16_t)(eol - p);
+
+        if (parser->discard)
+        {
+            /* Rest of a line that did not fit the carry buffer */
+            parser->discard = (eol == end);
+        }
+        else if (eol == end || parser->carry_len != 0)
+        {
+            /* Split line: gather it until its end arrives */
+            if (parser->carry_len + n > CMD_LINE_MAX)
+            {
+                parser->stats.overflow++;
+                parser->carry_len = 0;
+                parser->discard = (eol == end);
+            }
+            else
+            {
+                memcpy(&parser->carry[parser->carry_len], p, n);
+                parser->carry_len += n;
+                if (eol != end)
+                {
+                    parser->stats.carried++;
+                    Cmd_Line(parser, parser->carry, parser->carry_len);
+                    parser->carry_len = 0;
+                }
+            }
+        }
+        else
+        {
+            /* Whole line in this span, parse it in place */
+            Cmd_Line(parser, (const char *)p, n);
+        }
+
+        p = (eol == end) ? end : eol + 1;
+    }
+}
+
+/**
+  * @brief  Find the command of a name
+  * @param  name: command name, not terminated
+  * @param  len: name length
+  * @retval Table entry, NULL for an unknown name
+  */
+const Cmd_EntryTypeDef *Cmd_Lookup(const char *name, uint16_t len)
+{
+    const Cmd_EntryTypeDef *entry;
+
+    if (len == 0)
+    {
+        return NULL;
+    }
+
+    entry = &cmd_table[CMD_HASH(name, len)];
+    if (entry->len != len || memcmp(entry->name, name, len) != 0)
+    {
+        return NULL;
+    }
+
+    return entry;
+}
+
+/**
+  * @brief  Split one line into name and argument and run the command
+  * @param  parser: parser state, for the statistics
+  * @param  line: line without its terminator
+  * @param  len: line length
+  * @retval None
+  */
+static void Cmd_Line(Cmd_ParserTypeDef *parser, const char *line, uint16_t len)
+{
+    const Cmd_EntryTypeDef *entry;
+    uint16_t name_len = 0;
+    uint16_t arg = 0;
+
+    if (len == 0)
+    {
+        return;
+    }
+    parser->stats.lines++;
+
+    while (name_len < len && line[name_len] != ' ')
+    {
+        name_len++;
+    }
+    arg = name_len;
+    while (arg < len && line[arg] == ' ')
+    {
+        arg++;
+    }
+
+    entry = Cmd_Lookup(line, name_len);
+    if (entry == NULL)
+    {
+        parser->stats.unknown++;
+        return;
+    }
+
+    parser->stats.dispatched++;
+    entry->handler(&line[arg], (uint16_t)(len - arg));
+}
+
+/**
+  * @brief  First CR or LF in a span
+  * @param  p: span start
+  * @param  end: one past the span
+  * @retval Terminator position, end if there is none
+  */
+static const uint8_t *Cmd_FindEol(const uint8_t *p, const uint8_t *end)
+{
+    while (p < end && *p != '\n' && *p != '\r')
+    {
+        p++;
+    }
+    return p;
+}
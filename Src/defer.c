@@ -0,0 +1,146 @@
+/**
+  ******************************************************************************
+  * @file    Src/defer.c
+  * @brief   Deferred work queue drained by PendSV.
+  *
+  *          Interrupt handlers capture what happened and queue a function
+  *          with one argument through Defer_Post(), which also pends PendSV.
+  *          PendSV runs at the lowest priority, so it starts as soon as the
+  *          last peripheral handler returns, preempts main(), and runs every
+  *          item to completion in posting order. The DMA and UART handlers
+  *          stay a few dozen cycles long however much work an item does;
+  *          anything that has to wait on the hardware still belongs in the
+  *          main loop.
+  *
+  *          Producers reserve a slot by advancing the head with LDREX/STREX,
+  *          fill it and publish it by writing the function pointer last.
+  *          Only PendSV advances the tail. A slot that is reserved but not
+  *          yet published holds back the items behind it until its producer
+  *          finishes and pends PendSV again.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "defer.h"
+#include "mem_sections.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+    Defer_FuncTypeDef volatile func;    /* NULL while the slot is free */
+    uint32_t arg;
+} Defer_ItemTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define DEFER_MASK (DEFER_QUEUE_SIZE - 1U)
+
+/* Private variables ---------------------------------------------------------*/
+CCMRAM static Defer_ItemTypeDef defer_queue[DEFER_QUEUE_SIZE];
+CCMRAM static volatile uint32_t defer_head;     /* next slot to reserve */
+CCMRAM static volatile uint32_t defer_tail;     /* next slot to run */
+CCMRAM static Defer_StatsTypeDef defer_stats;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Empty the queue and drop PendSV to the lowest priority. Must run
+  *         before any interrupt that posts work is enabled.
+  * @param  None
+  * @retval None
+  */
+void Defer_Init(void)
+{
+    for (uint32_t i = 0; i < DEFER_QUEUE_SIZE; i++)
+    {
+        defer_queue[i].func = NULL;
+    }
+    defer_head = 0;
+    defer_tail = 0;
+    defer_stats.posted = 0;
+    defer_stats.run = 0;
+    defer_stats.dropped = 0;
+    defer_stats.depth_max = 0;
+
+    HAL_NVIC_SetPriority(PendSV_IRQn, DEFER_IRQ_PRIORITY, 0);
+}
+
+/**
+  * @brief  Queue func(arg) for PendSV. Safe from any interrupt priority and
+  *         from thread mode.
+  * @param  func: function to run, must not block
+  * @param  arg: passed to func
+  * @retval HAL_BUSY when the queue is full and the item was dropped
+  */
+RAMFUNC HAL_StatusTypeDef Defer_Post(Defer_FuncTypeDef func, uint32_t arg)
+{
+    Defer_ItemTypeDef *item;
+    uint32_t head;
+    uint32_t depth;
+
+    do
+    {
+        head = __LDREXW(&defer_head);
+        depth = head - defer_tail;
+        if (depth >= DEFER_QUEUE_SIZE)
+        {
+            __CLREX();
+            defer_stats.dropped++;
+            return HAL_BUSY;
+        }
+    } while (__STREXW(head + 1U, &defer_head) != 0U);
+
+    item = &defer_queue[head & DEFER_MASK];
+    item->arg = arg;
+    __DMB();
+    item->func = func;
+
+    defer_stats.posted++;
+    if (depth + 1U > defer_stats.depth_max)
+    {
+        defer_stats.depth_max = depth + 1U;
+    }
+
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+
+    return HAL_OK;
+}
+
+/**
+  * @brief  Run every published item in order, called from PendSV_Handler()
+  * @param  None
+  * @retval None
+  */
+void Defer_IRQHandler(void)
+{
+    for (;;)
+    {
+        Defer_ItemTypeDef *item = &defer_queue[defer_tail & DEFER_MASK];
+        Defer_FuncTypeDef func = item->func;
+        uint32_t arg;
+
+        if (func == NULL)
+        {
+            break;
+        }
+
+        /* Free the slot before the call so the item may post again */
+        arg = item->arg;
+        item->func = NULL;
+        defer_tail++;
+
+        func(arg);
+        defer_stats.run++;
+    }
+}
+
+/**
+  * @brief  Copy the queue statistics
+  * @param  stats: destination
+  * @retval None
+  */
+void Defer_GetStats(Defer_StatsTypeDef *stats)
+{
+    __disable_irq();
+    *stats = defer_stats;
+    __enable_irq();
+}
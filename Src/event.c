@@ -0,0 +1,241 @@
+/**
+  ******************************************************************************
+  * @file    Src/event.c
+  * @brief   Event flags posted from interrupts and the loop that waits on them.
+  *
+  *          Interrupt callbacks only post a bit with Event_Post(); main()
+  *          blocks in Event_Wait() and does the work in thread mode. While
+  *          nothing is pending the core sleeps in WFI, which stops it
+  *          fetching from flash and SRAM and leaves the bus matrix to the
+  *          DMA. The check and the WFI run with PRIMASK set, so a post that
+  *          lands in between still wakes the core: a pending interrupt ends
+  *          WFI even when it cannot be taken yet.
+  *
+  *          Dispatch latency is measured with the DWT cycle counter from the
+  *          first post to the return of Event_Wait(). Sleep time is measured
+  *          with SysTick, which keeps counting in Sleep mode while the DWT
+  *          counter may not.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "event.h"
+#include "uart_pool.h"
+#include "defer.h"
+#include "mem_sections.h"
+#include <stdio.h>
+
+/* Private define ------------------------------------------------------------*/
+/* Private variables ---------------------------------------------------------*/
+CCMRAM static volatile uint32_t event_flags = 0;
+CCMRAM static volatile uint32_t event_post_cycles;
+CCMRAM static Event_StatsTypeDef event_stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Event_SysTickCycles(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Enable the DWT cycle counter and clear the statistics
+  * @param  None
+  * @retval None
+  */
+void Event_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    event_stats.wakeups = 0;
+    event_stats.dispatched = 0;
+    event_stats.lat_min = UINT32_MAX;
+    event_stats.lat_max = 0;
+    event_stats.lat_total = 0;
+    event_stats.sleep_cycles = 0;
+    event_stats.start_tick = HAL_GetTick();
+}
+
+/**
+  * @brief  Set event bits and wake the main loop. Safe from any interrupt
+  *         priority and from thread mode.
+  * @param  events: bits to set
+  * @retval None
+  */
+RAMFUNC void Event_Post(uint32_t events)
+{
+    uint32_t old;
+
+    do
+    {
+        old = __LDREXW(&event_flags);
+    } while (__STREXW(old | events, &event_flags) != 0U);
+
+    if (old == 0U)
+    {
+        event_post_cycles = DWT->CYCCNT;
+    }
+
+#if EVENT_SLEEP_ON_EXIT
+    /* Return to main() instead of going back to sleep */
+    CLEAR_BIT(SCB->SCR, SCB_SCR_SLEEPONEXIT_Msk);
+#endif
+}
+
+/**
+  * @brief  Sleep until at least one event is pending, then take them all.
+  *         Must be called from thread mode.
+  * @param  None
+  * @retval Pending event bits, cleared on return
+  */
+uint32_t Event_Wait(void)
+{
+    uint32_t events;
+    uint32_t latency;
+
+    __disable_irq();
+    while (event_flags == 0U)
+    {
+#if EVENT_SLEEP
+        uint32_t t0 = Event_SysTickCycles();
+
+#if EVENT_SLEEP_ON_EXIT
+        SET_BIT(SCB->SCR, SCB_SCR_SLEEPONEXIT_Msk);
+#endif
+        __DSB();
+        __WFI();
+
+        /* Let the pending interrupt run. With SLEEPONEXIT the core sleeps
+           again on its return unless it posted an event, so the measured
+           sleep then also holds those short handler runs. */
+        __enable_irq();
+        __ISB();
+        __disable_irq();
+#if EVENT_SLEEP_ON_EXIT
+        CLEAR_BIT(SCB->SCR, SCB_SCR_SLEEPONEXIT_Msk);
+#endif
+        event_stats.sleep_cycles += Event_SysTickCycles() - t0;
+        event_stats.wakeups++;
+#else
+        __enable_irq();
+        __disable_irq();
+#endif
+    }
+
+    /* No handler can run before the flags are cleared */
+    events = event_flags;
+    event_flags = 0U;
+    latency = DWT->CYCCNT - event_post_cycles;
+    __enable_irq();
+
+    event_stats.dispatched++;
+    event_stats.lat_total += latency;
+    if (latency < event_stats.lat_min)
+    {
+        event_stats.lat_min = latency;
+    }
+    if (latency > event_stats.lat_max)
+    {
+        event_stats.lat_max = latency;
+    }
+
+    return events;
+}
+
+/**
+  * @brief  Copy the loop statistics
+  * @param  stats: destination
+  * @retval None
+  */
+void Event_GetStats(Event_StatsTypeDef *stats)
+{
+    __disable_irq();
+    *stats = event_stats;
+    __enable_irq();
+}
+
+/**
+  * @brief  Report dispatch latency, the share of time the core slept, i.e.
+  *         left the bus matrix to the DMA, and the PendSV work queue. Must be
+  *         called from thread mode.
+  * @param  None
+  * @retval HAL_BUSY while no TX pool block is free or the TX queue is full
+  */
+HAL_StatusTypeDef Event_Dump(void)
+{
+    Event_StatsTypeDef stats;
+    Defer_StatsTypeDef defer;
+    uint64_t wall;
+    uint32_t sleep_permille = 0;
+    uint32_t avg = 0;
+    HAL_StatusTypeDef status;
+    char *text;
+    int len;
+
+    /* The text is written straight into a TX pool block, which goes back
+       to the pool once it is sent */
+    text = (char *)UART_Pool_Alloc();
+    if (text == NULL)
+    {
+        return HAL_BUSY;
+    }
+
+    Event_GetStats(&stats);
+    Defer_GetStats(&defer);
+    wall = (uint64_t)(HAL_GetTick() - stats.start_tick) * (SysTick->LOAD + 1U);
+    if (wall != 0U)
+    {
+        sleep_permille = (uint32_t)((stats.sleep_cycles * 1000U) / wall);
+    }
+    if (stats.dispatched != 0U)
+    {
+        avg = (uint32_t)(stats.lat_total / stats.dispatched);
+    }
+    else
+    {
+        stats.lat_min = 0;
+    }
+
+    len = snprintf(text, UART_POOL_BLOCK_SIZE,
+                   "events n=%lu wakeups=%lu lat min=%lu avg=%lu max=%lu cycles\r\n"
+                   "asleep %lu.%lu%% (bus free for DMA)\r\n"
+                   "deferred n=%lu dropped=%lu depth max=%lu\r\n",
+                   (unsigned long)stats.dispatched, (unsigned long)stats.wakeups,
+                   (unsigned long)stats.lat_min, (unsigned long)avg,
+                   (unsigned long)stats.lat_max,
+                   (unsigned long)(sleep_permille / 10U),
+                   (unsigned long)(sleep_permille % 10U),
+                   (unsigned long)defer.run, (unsigned long)defer.dropped,
+                   (unsigned long)defer.depth_max);
+    if (len > UART_POOL_BLOCK_SIZE - 1)
+    {
+        len = UART_POOL_BLOCK_SIZE - 1;
+    }
+
+    status = UART_Pool_Send(UART_PORT_HC05, (uint8_t *)text, (uint16_t)len);
+    if (status != HAL_OK)
+    {
+        UART_Pool_Free((uint8_t *)text);
+    }
+    return status;
+}
+
+/**
+  * @brief  Core clock cycles since boot as counted by SysTick. Must be
+  *         called with interrupts disabled.
+  * @param  None
+  * @retval Cycle count, wraps every 2^32 cycles
+  */
+static uint32_t Event_SysTickCycles(void)
+{
+    uint32_t reload = SysTick->LOAD + 1U;
+    uint32_t tick = HAL_GetTick();
+    uint32_t val = SysTick->VAL;
+
+    /* The counter wrapped but the tick interrupt could not run yet */
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U && val > reload / 2U)
+    {
+        tick++;
+    }
+
+    return tick * reload + (reload - 1U - val);
+}
@@ -0,0 +1,275 @@
+/**
+  ******************************************************************************
+  * @file    Src/hc05.c
+  * @brief   Runtime rate change of the USART6 <-> HC-05 link.
+  *
+  *          HC05_SetBaudRate() moves both ends in lockstep:
+  *            1. KEY is raised and AT+UART=<rate>,0,0 is sent at the current
+  *               rate; the module must answer OK. The HC-05 only stores the
+  *               rate, it keeps using the old one until it restarts.
+  *            2. AT+RESET reboots the module. KEY is dropped at once so it
+  *               boots into data mode at the stored rate (KEY high at boot
+  *               selects the fixed 38400 command mode instead).
+  *            3. Once it has booted, USART6 is re-initialised at the new
+  *               rate, KEY is raised again and a bare AT is sent; an OK
+  *               proves both ends agree.
+  *            4. If the probe fails, the module is looked for at the old
+  *               rate and, if it did switch, told to go back and restarted
+  *               again, so the link is never left with mismatched ends.
+  *
+  *          The restart drops the Bluetooth connection; the remote side has
+  *          to reconnect after every rate change.
+  *
+  *          Runs in thread mode only: it waits for the TX queue to drain and
+  *          polls for the module's answer with HAL_GetTick() timeouts.
+  *          Responses arrive through the normal RX path; the application
+  *          forwards received bytes to HC05_RxFeed().
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "hc05.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "mem_sections.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Private define ------------------------------------------------------------*/
+#define AT_RESP_SIZE 32
+
+/* Private variables ---------------------------------------------------------*/
+const uint32_t hc05_baudrates[] =
+{
+    9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600, 1382400
+};
+const uint32_t hc05_baudrate_count = sizeof(hc05_baudrates) / sizeof(hc05_baudrates[0]);
+
+static UART_PortTypeDef hc05_port;
+static UART_HandleTypeDef *hc05_huart;
+DMA_BUFFER static char at_cmd[AT_RESP_SIZE];
+static char at_resp[AT_RESP_SIZE];
+static volatile uint16_t at_resp_len = 0;
+static volatile bool at_pending = false;
+
+/* Private function prototypes -----------------------------------------------*/
+static HAL_StatusTypeDef HC05_Command(const char *cmd);
+static HAL_StatusTypeDef HC05_Restart(uint32_t baud);
+static HAL_StatusTypeDef HC05_ApplyLocalBaud(uint32_t baud);
+static void HC05_WaitTxIdle(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Configure the KEY pin and remember the UART wired to the module
+  * @param  port: UART port connected to the HC-05
+  * @retval None
+  */
+void HC05_Init(UART_PortTypeDef port)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    hc05_port = port;
+    hc05_huart = UART_Port_Handle(port);
+
+    __HAL_RCC_GPIOD_CLK_ENABLE();
+    HAL_GPIO_WritePin(HC05_KEY_PORT, HC05_KEY_PIN, GPIO_PIN_RESET);
+    GPIO_InitStruct.Pin = HC05_KEY_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(HC05_KEY_PORT, &GPIO_InitStruct);
+}
+
+/**
+  * @brief  Change the link rate on both ends, falling back to the current
+  *         rate if the module does not follow. Restarts the module, which
+  *         takes HC05_RESET_MS and drops the Bluetooth connection.
+  * @param  baud: new rate, one of hc05_baudrates[]
+  * @retval HAL_OK on success, HAL_ERROR if the rate is unsupported or was
+  *         refused, HAL_TIMEOUT if the module stopped answering (the old rate
+  *         has been restored in both cases)
+  */
+HAL_StatusTypeDef HC05_SetBaudRate(uint32_t baud)
+{
+    uint32_t old = hc05_huart->Init.BaudRate;
+    HAL_StatusTypeDef status = HAL_ERROR;
+    char cmd[AT_RESP_SIZE];
+
+    for (uint32_t i = 0; i < hc05_baudrate_count; i++)
+    {
+        if (hc05_baudrates[i] == baud)
+        {
+            status = HAL_OK;
+        }
+    }
+    if (status != HAL_OK || baud == old)
+    {
+        return status;
+    }
+
+    HAL_GPIO_WritePin(HC05_KEY_PORT, HC05_KEY_PIN, GPIO_PIN_SET);
+
+    snprintf(cmd, sizeof(cmd), "AT+UART=%lu,0,0\r\n", (unsigned long)baud);
+    status = HC05_Command(cmd);
+    if (status == HAL_OK)
+    {
+        status = HC05_Restart(baud);
+        if (status != HAL_OK)
+        {
+            /* Peer did not come back at the new rate. Still at the old one
+               it answers there; otherwise ask it to return and restart it */
+            HC05_ApplyLocalBaud(old);
+            if (HC05_Command("AT\r\n") != HAL_OK)
+            {
+                HC05_ApplyLocalBaud(baud);
+                snprintf(cmd, sizeof(cmd), "AT+UART=%lu,0,0\r\n", (unsigned long)old);
+                if (HC05_Command(cmd) != HAL_OK || HC05_Restart(old) != HAL_OK)
+                {
+                    HC05_ApplyLocalBaud(old);
+                }
+            }
+        }
+    }
+
+    HAL_GPIO_WritePin(HC05_KEY_PORT, HC05_KEY_PIN, GPIO_PIN_RESET);
+    return status;
+}
+
+/**
+  * @brief  Current local link rate
+  * @param  None
+  * @retval Baud rate
+  */
+uint32_t HC05_GetBaudRate(void)
+{
+    return hc05_huart->Init.BaudRate;
+}
+
+/**
+  * @brief  Collect a module response while an AT command is pending. Called
+  *         from the RX data callback.
+  * @param  data: received bytes
+  * @param  len: number of bytes
+  * @retval None
+  */
+void HC05_RxFeed(const uint8_t *data, uint16_t len)
+{
+    uint16_t n = at_resp_len;
+
+    if (!at_pending)
+    {
+        return;
+    }
+    while (len-- > 0 && n < AT_RESP_SIZE - 1)
+    {
+        at_resp[n++] = (char)*data++;
+    }
+    at_resp[n] = '\0';
+    at_resp_len = n;
+}
+
+/**
+  * @brief  Send one AT command and wait for OK or ERROR
+  * @param  cmd: command including CR LF
+  * @retval HAL_OK, HAL_ERROR on ERROR, HAL_TIMEOUT without an answer
+  */
+static HAL_StatusTypeDef HC05_Command(const char *cmd)
+{
+    uint32_t start;
+
+    /* The TX queue keeps a pointer to the command until it is sent */
+    HC05_WaitTxIdle();
+    strncpy(at_cmd, cmd, sizeof(at_cmd) - 1);
+
+    at_resp_len = 0;
+    at_resp[0] = '\0';
+    at_pending = true;
+
+    if (UART_TX_Send(hc05_port, (const uint8_t *)at_cmd, (uint16_t)strlen(at_cmd)) != HAL_OK)
+    {
+        at_pending = false;
+        return HAL_ERROR;
+    }
+
+    start = HAL_GetTick();
+    while ((HAL_GetTick() - start) < HC05_AT_TIMEOUT_MS)
+    {
+        if (strstr(at_resp, "OK\r\n") != NULL)
+        {
+            at_pending = false;
+            return HAL_OK;
+        }
+        if (strstr(at_resp, "ERROR") != NULL)
+        {
+            at_pending = false;
+            return HAL_ERROR;
+        }
+    }
+
+    at_pending = false;
+    return HAL_TIMEOUT;
+}
+
+/**
+  * @brief  Reboot the module so it takes up the rate stored by AT+UART, then
+  *         follow it and check it answers. Expects KEY high, leaves it high.
+  * @param  baud: rate the module restarts at
+  * @retval HAL_OK once the module answered AT at that rate
+  */
+static HAL_StatusTypeDef HC05_Restart(uint32_t baud)
+{
+    HAL_StatusTypeDef status = HC05_Command("AT+RESET\r\n");
+
+    /* KEY must be low while it boots or it comes up in 38400 command mode */
+    HAL_GPIO_WritePin(HC05_KEY_PORT, HC05_KEY_PIN, GPIO_PIN_RESET);
+    if (status != HAL_OK)
+    {
+        HAL_GPIO_WritePin(HC05_KEY_PORT, HC05_KEY_PIN, GPIO_PIN_SET);
+        return status;
+    }
+    HAL_Delay(HC05_RESET_MS);
+
+    status = HC05_ApplyLocalBaud(baud);
+    HAL_GPIO_WritePin(HC05_KEY_PORT, HC05_KEY_PIN, GPIO_PIN_SET);
+    if (status == HAL_OK)
+    {
+        status = HC05_Command("AT\r\n");
+    }
+    return status;
+}
+
+/**
+  * @brief  Re-initialise the UART at a new rate and restart reception
+  * @param  baud: new rate
+  * @retval HAL status
+  */
+static HAL_StatusTypeDef HC05_ApplyLocalBaud(uint32_t baud)
+{
+    HC05_WaitTxIdle();
+
+    HAL_UART_AbortReceive(hc05_huart);
+    hc05_huart->Init.BaudRate = baud;
+    if (HAL_UART_Init(hc05_huart) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+    return UART_RX_Start(hc05_port);
+}
+
+/**
+  * @brief  Wait until every queued byte has left the USART
+  * @param  None
+  * @retval None
+  */
+static void HC05_WaitTxIdle(void)
+{
+    while (!UART_TX_IsIdle(hc05_port))
+    {
+    }
+    /* The fast path completes on DMA TC, before the last byte is shifted */
+    while (!__HAL_UART_GET_FLAG(hc05_huart, UART_FLAG_TC))
+    {
+    }
+}
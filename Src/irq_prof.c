@@ -0,0 +1,179 @@
+/**
+  ******************************************************************************
+  * @file    Src/irq_prof.c
+  * @brief   Interrupt handler profiling with the Cortex-M4 DWT cycle counter.
+  *
+  *          Handlers in stm32f4xx_it.c bracket their body with IRQ_PROF_ENTER()
+  *          and IRQ_PROF_EXIT(); the elapsed CYCCNT delta is folded into
+  *          min/max/total and a log2 histogram. Entry latency is recorded
+  *          where the hardware exposes when the event happened, which is the
+  *          case for SysTick (cycles elapsed since the counter reloaded).
+  *
+  *          Everything here is compiled out unless IRQ_PROF_ENABLED is 1.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "irq_prof.h"
+
+#if IRQ_PROF_ENABLED
+
+#include "uart_tx.h"
+#include "mem_sections.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define PROF_DUMP_BUFSIZE 1536
+
+/* Private variables ---------------------------------------------------------*/
+CCMRAM IRQ_Prof_EntryTypeDef irq_prof[IRQ_PROF_COUNT];
+
+static const char *const prof_names[IRQ_PROF_COUNT] =
+{
+    "SysTick", "EXTI0", "DMA2_S1", "DMA2_S6", "USART6", "PendSV", "TIM3", "DMA2_S0",
+    "DMA2_S3", "TxCplt"
+};
+DMA_BUFFER static char prof_dump_buf[PROF_DUMP_BUFSIZE];
+static uint32_t prof_dump_ticket;       /* UART_TX_Queued() after the last dump */
+static bool prof_dump_sent;
+
+/* Private function prototypes -----------------------------------------------*/
+static int Prof_Format(char *buf, size_t size, const char *name,
+                       const char *what, const IRQ_Prof_StatTypeDef *stat);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Enable the DWT cycle counter and clear the statistics
+  * @param  None
+  * @retval None
+  */
+void IRQ_Prof_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    IRQ_Prof_Reset();
+}
+
+/**
+  * @brief  Clear the statistics of every handler
+  * @param  None
+  * @retval None
+  */
+void IRQ_Prof_Reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    memset(irq_prof, 0, sizeof(irq_prof));
+    for (uint32_t i = 0; i < IRQ_PROF_COUNT; i++)
+    {
+        irq_prof[i].exec.min = UINT32_MAX;
+        irq_prof[i].latency.min = UINT32_MAX;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Fold one sample into a statistic
+  * @param  stat: statistic to update
+  * @param  cycles: sample in CPU cycles
+  * @retval None
+  */
+void IRQ_Prof_Record(IRQ_Prof_StatTypeDef *stat, uint32_t cycles)
+{
+    uint32_t bucket = 31U - __CLZ(cycles | 1U);
+
+    if (bucket >= IRQ_PROF_BUCKETS)
+    {
+        bucket = IRQ_PROF_BUCKETS - 1;
+    }
+
+    stat->count++;
+    stat->total += cycles;
+    stat->hist[bucket]++;
+    if (cycles < stat->min)
+    {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max)
+    {
+        stat->max = cycles;
+    }
+}
+
+/**
+  * @brief  Format the statistics as text and queue them on the HC-05 link.
+  *         Must be called from thread mode.
+  * @param  None
+  * @retval HAL_BUSY while the previous dump is still queued or the queue
+  *         is full
+  */
+HAL_StatusTypeDef IRQ_Prof_Dump(void)
+{
+    HAL_StatusTypeDef status;
+    int len = 0;
+
+    /* The text buffer is reused, only refill it once the last dump has left
+       the queue; other traffic on the link does not hold it back */
+    if (prof_dump_sent &&
+        (int32_t)(UART_TX_Retired(UART_PORT_HC05) - prof_dump_ticket) < 0)
+    {
+        return HAL_BUSY;
+    }
+
+    len += snprintf(prof_dump_buf, sizeof(prof_dump_buf), "irq cycles @%lu Hz\r\n",
+                    (unsigned long)SystemCoreClock);
+    for (uint32_t i = 0; i < IRQ_PROF_COUNT && len < PROF_DUMP_BUFSIZE; i++)
+    {
+        len += Prof_Format(&prof_dump_buf[len], sizeof(prof_dump_buf) - len,
+                           prof_names[i], "exec", &irq_prof[i].exec);
+        if (irq_prof[i].latency.count != 0 && len < PROF_DUMP_BUFSIZE)
+        {
+            len += Prof_Format(&prof_dump_buf[len], sizeof(prof_dump_buf) - len,
+                               prof_names[i], "lat", &irq_prof[i].latency);
+        }
+    }
+    if (len > PROF_DUMP_BUFSIZE - 1)
+    {
+        len = PROF_DUMP_BUFSIZE - 1;
+    }
+
+    status = UART_TX_Send(UART_PORT_HC05, (const uint8_t *)prof_dump_buf, (uint16_t)len);
+    if (status == HAL_OK)
+    {
+        prof_dump_ticket = UART_TX_Queued(UART_PORT_HC05);
+        prof_dump_sent = true;
+    }
+    return status;
+}
+
+/**
+  * @brief  Format one statistic as "name what n= min= avg= max= | histogram"
+  * @retval Number of characters written (as snprintf)
+  */
+static int Prof_Format(char *buf, size_t size, const char *name,
+                       const char *what, const IRQ_Prof_StatTypeDef *stat)
+{
+    int len;
+    uint32_t avg = stat->count ? (uint32_t)(stat->total / stat->count) : 0;
+
+    len = snprintf(buf, size, "%-8s %-4s n=%lu min=%lu avg=%lu max=%lu |",
+                   name, what, (unsigned long)stat->count,
+                   (unsigned long)(stat->count ? stat->min : 0),
+                   (unsigned long)avg, (unsigned long)stat->max);
+    for (uint32_t b = 0; b < IRQ_PROF_BUCKETS && len < (int)size; b++)
+    {
+        len += snprintf(&buf[len], size - len, " %lu", (unsigned long)stat->hist[b]);
+    }
+    if (len < (int)size)
+    {
+        len += snprintf(&buf[len], size - len, "\r\n");
+    }
+    return len;
+}
+
+#endif /* IRQ_PROF_ENABLED */
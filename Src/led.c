@@ -0,0 +1,130 @@
+/**
+  ******************************************************************************
+  * @file    Src/led.c
+  * @brief   Non-blocking LED indicators for the four Discovery board LEDs.
+  *
+  *          LED_Blink() only queues a pattern and returns; LED_TickISR(),
+  *          called every millisecond from SysTick_Handler(), plays the queued
+  *          patterns one after another. Interrupt callbacks can therefore
+  *          signal events without HAL_Delay(), which cannot work there anyway
+  *          since SysTick has the lowest priority and never preempts them.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "led.h"
+#include "mem_sections.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+    uint8_t count;
+    uint16_t half_period;
+} LED_PatternTypeDef;
+
+typedef struct
+{
+    LED_PatternTypeDef queue[LED_QUEUE_LEN];
+    volatile uint8_t head;    /* written by LED_Blink() */
+    volatile uint8_t tail;    /* written by LED_TickISR() */
+    uint16_t steps;           /* pin changes left in the current pattern */
+    uint16_t half_period;
+    uint16_t timer;
+} LED_StateTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define LED_QUEUE_MASK (LED_QUEUE_LEN - 1)
+
+#if (LED_QUEUE_LEN & LED_QUEUE_MASK) != 0
+#error "LED_QUEUE_LEN must be a power of two"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static const uint16_t led_pins[LED_COUNT] =
+{
+    GPIO_PIN_12, GPIO_PIN_13, GPIO_PIN_14, GPIO_PIN_15
+};
+CCMRAM static LED_StateTypeDef led_state[LED_COUNT];
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Turn an LED on immediately
+  * @param  led: LED to drive
+  * @retval None
+  */
+void LED_On(LED_TypeDef led)
+{
+    HAL_GPIO_WritePin(GPIOD, led_pins[led], GPIO_PIN_SET);
+}
+
+/**
+  * @brief  Turn an LED off immediately
+  * @param  led: LED to drive
+  * @retval None
+  */
+void LED_Off(LED_TypeDef led)
+{
+    HAL_GPIO_WritePin(GPIOD, led_pins[led], GPIO_PIN_RESET);
+}
+
+/**
+  * @brief  Queue a blink pattern, safe from thread and interrupt context
+  * @param  led: LED to blink
+  * @param  count: number of blinks
+  * @param  period_ms: duration of one on/off cycle
+  * @retval HAL_BUSY if the LED already has LED_QUEUE_LEN patterns waiting
+  */
+HAL_StatusTypeDef LED_Blink(LED_TypeDef led, uint8_t count, uint16_t period_ms)
+{
+    LED_StateTypeDef *st = &led_state[led];
+    uint8_t head = st->head;
+
+    if ((uint8_t)(head - st->tail) >= LED_QUEUE_LEN)
+    {
+        return HAL_BUSY;
+    }
+
+    st->queue[head & LED_QUEUE_MASK].count = count;
+    st->queue[head & LED_QUEUE_MASK].half_period = (period_ms < 2) ? 1 : period_ms / 2;
+    __DMB();
+    st->head = head + 1;
+
+    return HAL_OK;
+}
+
+/**
+  * @brief  Advance the blink patterns by one millisecond
+  * @param  None
+  * @retval None
+  */
+void LED_TickISR(void)
+{
+    for (uint32_t i = 0; i < LED_COUNT; i++)
+    {
+        LED_StateTypeDef *st = &led_state[i];
+
+        if (st->steps == 0)
+        {
+            LED_PatternTypeDef *p;
+
+            if (st->tail == st->head)
+            {
+                continue;
+            }
+            p = &st->queue[st->tail & LED_QUEUE_MASK];
+            st->steps = (uint16_t)p->count * 2;
+            st->half_period = p->half_period;
+            st->timer = 1;
+            st->tail++;
+        }
+
+        if (st->steps != 0 && --st->timer == 0)
+        {
+            /* Even step count left: switch on, odd: switch off */
+            HAL_GPIO_WritePin(GPIOD, led_pins[i], (st->steps & 1U) ? GPIO_PIN_RESET : GPIO_PIN_SET);
+            st->steps--;
+            st->timer = st->half_period;
+        }
+    }
+}
@@ -18,6 +18,25 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "led.h"
+#include "irq_prof.h"
+#include "hc05.h"
+#include "bench.h"
+#include "packet.h"
+#include "uart_flow.h"
+#include "mem_sections.h"
+#include "event.h"
+#include "uart_port.h"
+#include "defer.h"
+#include "uart_log.h"
+#include "tlog.h"
+#include "cmd.h"
+#include "msg.h"
+#include "uart_pool.h"
+#include "accel.h"
+#include "timebase.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -31,24 +50,59 @@
   */
 
 /* Private typedef -----------------------------------------------------------*/
-UART_HandleTypeDef huart6;
-DMA_HandleTypeDef hdma_usart6_tx;
-
 /* Private define ------------------------------------------------------------*/
 #define TX_BUFSIZE 128
 
+/* Events handled by the main loop */
+#define EVT_BUTTON          (1UL << 0)
+#define EVT_TX_DONE         (1UL << 1)
+#define EVT_PROF_DUMP       (1UL << 2)
+#define EVT_BAUD_SWEEP      (1UL << 3)
+#define EVT_CONTENTION      (1UL << 4)
+#define EVT_EVENT_DUMP      (1UL << 5)
+#define EVT_TLOG            (1UL << 6)
+#define EVT_HELP            (1UL << 7)
+#define EVT_STATS           (1UL << 8)
+#define EVT_SET_MSG         (1UL << 9)
+#define EVT_SET_BAUD        (1UL << 10)
+#define EVT_STREAM          (1UL << 11)
+#define EVT_ACCEL           (1UL << 12)
+#define EVT_SET_ACCEL       (1UL << 13)
+#define EVT_TX_COST         (1UL << 14)
+
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-static uint8_t tx_buf[TX_BUFSIZE];
+/* The button sends a canned message from flash until "msg" sets one, which
+   is copied into tx_buf. tx_buf may be rewritten once each port's urgent
+   retired count reaches the ticket read after queueing it there. */
+DMA_BUFFER static uint8_t tx_buf[TX_BUFSIZE];
+static const uint8_t *tx_msg;
 static uint16_t tx_len = 0;
-static volatile bool dma_tx_busy = false;
+static uint32_t tx_ticket[UART_PORT_COUNT];
+
+/* Commands, parsed per port from the RX ring. Staged values are written from
+   PendSV and taken by the main loop. */
+static Cmd_ParserTypeDef cmd_parser[UART_PORT_COUNT];
+static char msg_next[TX_BUFSIZE];
+static volatile uint16_t msg_next_len;
+static volatile uint32_t baud_next;
+static volatile uint32_t stream_ms_next;
+static volatile uint32_t accel_hz_next;
+
+/* Time of the last accepted button press, and the longest delay from an RX
+   DMA event to its bytes reaching the parser, per port */
+static volatile uint32_t button_us;
+static uint32_t rx_lat_max_us[UART_PORT_COUNT];
 
 /* Private function prototypes -----------------------------------------------*/
 static void SystemClock_Config(void);
 static void Error_Handler(void);
 static void GPIO_Init(void);
-static void USART6_Init(void);
-static void DMA_Init(void);
+static void UART_Init(void);
+static void Button_Send(void);
+static void TX_Done(uint32_t arg);
+static HAL_StatusTypeDef Message_Apply(void);
+static void Stats_Print(void);
 
 /* Private functions ---------------------------------------------------------*/
 
@@ -64,18 +118,39 @@ int main(void)
     
     /* Configure the system clock */
     SystemClock_Config();
+
+    /* Microsecond time stamps for I/O events, before any I/O starts */
+    if (Timebase_Init() != HAL_OK)
+    {
+        Error_Handler();
+    }
+
+    /* Start the DWT cycle counter for interrupt profiling (no-op unless
+       IRQ_PROF_ENABLED) */
+    IRQ_Prof_Init();
+    Event_Init();
+    Defer_Init();
     
     /* Initialize all configured peripherals */
     GPIO_Init();
-    DMA_Init();      
-    USART6_Init();  
+    UART_Pool_Init();
+    UART_Init();
+    UART_Log_Init();
+    HC05_Init(UART_PORT_HC05);
+    Packet_Init();
+    TLog_Init();
+    if (Accel_Init() != HAL_OK)
+    {
+        printf("accel: no LIS3DSH\r\n");
+    }
+    for (uint32_t i = 0; i < UART_PORT_COUNT; i++)
+    {
+        Cmd_Init(&cmd_parser[i]);
+    }
 
-    /* Prepare message */
-    const char *hello = "Hello from STM32 via HC-05\r\n";
-    tx_len = strlen(hello);
-    if (tx_len > TX_BUFSIZE) 
-        tx_len = TX_BUFSIZE;
-    memcpy(tx_buf, hello, tx_len);
+    /* The button message starts as the canned greeting, read from flash */
+    tx_msg = msg_table[MSG_HELLO].data;
+    tx_len = msg_table[MSG_HELLO].len;
 
     /* Blink GREEN LED to indicate successful initialization */
     HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_SET);
@@ -83,10 +158,148 @@ int main(void)
     HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_RESET);
     HAL_Delay(300);
 
-    /* Infinite loop */
+    /* stdout is queued on the TX DMA, printf() returns once formatted */
+    printf("Ready, core at %lu Hz\r\n", (unsigned long)SystemCoreClock);
+
+    /* Infinite loop - sleep until an interrupt posts work, then do it here
+       in thread mode */
+    bool prof_dump_pending = false;
+    bool event_dump_pending = false;
+    bool msg_pending = false;
+
     while (1)
     {
-        /* Main loop - waiting for button interrupt */
+        uint32_t events = Event_Wait();
+
+        /* Log text written while the previous region was on the wire */
+        if (events & EVT_TX_DONE)
+        {
+            UART_Log_Flush();
+        }
+
+        /* Keep the benchmark frames queued */
+        if (events & EVT_TX_DONE)
+        {
+            BENCH_StreamPoll();
+        }
+
+        /* Accelerometer frames, coded as batches fill and sent as the TX
+           queue frees frame buffers */
+        if (events & (EVT_TX_DONE | EVT_ACCEL))
+        {
+            Accel_Poll();
+        }
+
+        /* Tokenized log records, batched while the link is busy */
+        if (events & (EVT_TX_DONE | EVT_TLOG))
+        {
+            TLog_Flush();
+        }
+
+        /* A new button message waits until no port still queues the old one */
+        if (events & EVT_SET_MSG)
+        {
+            msg_pending = true;
+        }
+        if (msg_pending && Message_Apply() != HAL_BUSY)
+        {
+            msg_pending = false;
+        }
+
+        if (events & EVT_BUTTON)
+        {
+            Button_Send();
+        }
+
+        /* Dumps wait for their text buffer, an idle TX queue or a free pool
+           block, and are retried on every later TX completion */
+        if (events & EVT_PROF_DUMP)
+        {
+            prof_dump_pending = true;
+        }
+        if (events & EVT_EVENT_DUMP)
+        {
+            event_dump_pending = true;
+        }
+
+        /* Interrupt profile requested over the link */
+        if (prof_dump_pending && IRQ_Prof_Dump() != HAL_BUSY)
+        {
+            prof_dump_pending = false;
+        }
+
+        /* Dispatch latency and sleep share of this loop */
+        if (event_dump_pending && Event_Dump() != HAL_BUSY)
+        {
+            event_dump_pending = false;
+        }
+
+        /* Throughput at every supported link rate */
+        if (events & EVT_BAUD_SWEEP)
+        {
+            BENCH_BaudSweep();
+        }
+
+        /* CPU slowdown caused by the TX DMA in the configured DMA mode */
+        if (events & EVT_CONTENTION)
+        {
+            BENCH_BusContention();
+        }
+
+        /* Interrupt cycles per span on the HAL and fast TX paths */
+        if (events & EVT_TX_COST)
+        {
+            BENCH_TxCost();
+        }
+
+        /* Pattern frame stream, started or stopped by "stream" or the
+           button */
+        if (events & EVT_STREAM)
+        {
+            if (BENCH_StreamIsRunning())
+            {
+                BENCH_StreamStop();
+            }
+            else
+            {
+                BENCH_StreamStart(stream_ms_next);
+            }
+        }
+
+        /* Accelerometer telemetry started, restarted or stopped by "accel" */
+        if (events & EVT_SET_ACCEL)
+        {
+            uint32_t hz = accel_hz_next;
+
+            if (hz == 0)
+            {
+                Accel_Stop();
+                printf("accel stopped\r\n");
+            }
+            else
+            {
+                printf("accel %lu Hz: %s\r\n", (unsigned long)hz,
+                       (Accel_Start(hz) == HAL_OK) ? "ok" : "failed");
+            }
+        }
+
+        if (events & EVT_SET_BAUD)
+        {
+            uint32_t baud = baud_next;
+
+            printf("baud %lu: %s\r\n", (unsigned long)baud,
+                   (HC05_SetBaudRate(baud) == HAL_OK) ? "ok" : "failed");
+        }
+
+        if (events & EVT_STATS)
+        {
+            Stats_Print();
+        }
+
+        if (events & EVT_HELP)
+        {
+            (void)Msg_Send(UART_PORT_HC05, MSG_HELP);
+        }
     }
 }
 
@@ -159,58 +372,31 @@ static void SystemClock_Config(void)
     }
 }
 
-static void DMA_Init(void)
+/**
+  * @brief  Bring up every UART port of the table with its TX queue and
+  *         start circular DMA reception, which runs for the lifetime of the
+  *         firmware
+  * @param  None
+  * @retval None
+  */
+static void UART_Init(void)
 {
-    /* DMA controller clock enable */
-    __HAL_RCC_DMA2_CLK_ENABLE();
-  
-    /* Configure DMA request hdma_usart6_tx on DMA2_Stream6 */
-    hdma_usart6_tx.Instance = DMA2_Stream6;
-    hdma_usart6_tx.Init.Channel = DMA_CHANNEL_5;
-    hdma_usart6_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
-    hdma_usart6_tx.Init. PeriphInc = DMA_PINC_DISABLE;
-    hdma_usart6_tx.Init.MemInc = DMA_MINC_ENABLE;
-    hdma_usart6_tx.Init. PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
-    hdma_usart6_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-    hdma_usart6_tx.Init.Mode = DMA_NORMAL;
-    hdma_usart6_tx.Init.Priority = DMA_PRIORITY_LOW;
-    hdma_usart6_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
-    
-    if (HAL_DMA_Init(&hdma_usart6_tx) != HAL_OK)
+    for (uint32_t i = 0; i < UART_PORT_COUNT; i++)
     {
-        Error_Handler();
-    }
-
-    /* DMA interrupt init */
-    HAL_NVIC_SetPriority(DMA2_Stream6_IRQn, 5, 0);
-    HAL_NVIC_EnableIRQ(DMA2_Stream6_IRQn);
-}
+        UART_PortTypeDef port = (UART_PortTypeDef)i;
+        uint32_t baudrate = (port == UART_PORT_HC05) ? HC05_DEFAULT_BAUDRATE
+                                                     : UART_PORT_DEFAULT_BAUDRATE;
 
-static void USART6_Init(void)
-{
-    /* Peripheral clock enable */
-    __HAL_RCC_USART6_CLK_ENABLE();
-    
-    huart6.Instance = USART6;
-    huart6.Init.BaudRate = 9600;
-    huart6.Init.WordLength = UART_WORDLENGTH_8B;
-    huart6.Init.StopBits = UART_STOPBITS_1;
-    huart6.Init.Parity = UART_PARITY_NONE;
-    huart6.Init.Mode = UART_MODE_TX_RX;
-    huart6.Init.HwFlowCtl = UART_HWCONTROL_NONE;
-    huart6.Init. OverSampling = UART_OVERSAMPLING_16;
-    
-    if (HAL_UART_Init(&huart6) != HAL_OK)
-    {
-        Error_Handler();
+        if (UART_Port_Init(port, baudrate) != HAL_OK)
+        {
+            Error_Handler();
+        }
+        UART_TX_Init(port);
+        if (UART_RX_Start(port) != HAL_OK)
+        {
+            Error_Handler();
+        }
     }
-    
-    /* Link DMA handle to UART handle */
-    __HAL_LINKDMA(&huart6, hdmatx, hdma_usart6_tx);
-    
-    /* CRITICAL: Enable USART6 interrupt for TxCpltCallback to work */
-    HAL_NVIC_SetPriority(USART6_IRQn, 5, 0);
-    HAL_NVIC_EnableIRQ(USART6_IRQn);
 }
  
 static void GPIO_Init(void)
@@ -219,7 +405,6 @@ static void GPIO_Init(void)
     
     /* GPIO Ports Clock Enable */
     __HAL_RCC_GPIOA_CLK_ENABLE();
-    __HAL_RCC_GPIOC_CLK_ENABLE();
     __HAL_RCC_GPIOD_CLK_ENABLE();
     
     /* Configure GPIO pin Output Level */
@@ -232,14 +417,6 @@ static void GPIO_Init(void)
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
     HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
 
-    /* Configure GPIO pins : PC6 PC7 (USART6 TX/RX) */
-    GPIO_InitStruct.Pin = GPIO_PIN_6 | GPIO_PIN_7;
-    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
-    GPIO_InitStruct.Alternate = GPIO_AF8_USART6;
-    HAL_GPIO_Init(GPIOC, &GPIO_InitStruct);
-
     /* Configure GPIO pin :  PA0 (User Button) */
     GPIO_InitStruct.Pin = GPIO_PIN_0;
     GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
@@ -258,22 +435,244 @@ static void GPIO_Init(void)
   */
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
-    if (huart->Instance == USART6)
+    IRQ_PROF_ENTER(IRQ_PROF_TX_CPLT);
+    /* Retire the finished span and chain the next queued one */
+    UART_TX_CompleteISR(UART_Port_FromHandle(huart));
+    IRQ_PROF_EXIT(IRQ_PROF_TX_CPLT);
+}
+
+/**
+  * @brief  TX queue span complete callback, from the HAL path above or
+  *         straight from the DMA interrupt on the fast path
+  * @param  port: UART port
+  * @retval None
+  */
+void UART_TX_CompleteCallback(UART_PortTypeDef port)
+{
+    /* The next span is already chained, the rest can wait for PendSV */
+    Defer_Post(TX_Done, (uint32_t)port);
+}
+
+/**
+  * @brief  Completed transmission feedback, runs from PendSV
+  * @param  arg: UART port
+  * @retval None
+  */
+static void TX_Done(uint32_t arg)
+{
+    UART_PortTypeDef port = (UART_PortTypeDef)arg;
+
+    if (port == UART_PORT_HC05)
     {
-        /* Turn OFF GREEN LED */
-        HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_RESET);
-        
-        /* Clear busy flag */
-        dma_tx_busy = false;
-        
-        /* Blink BLUE LED 3 times to indicate transmission complete */
-        for (int i = 0; i < 3; i++)
+        /* Turn OFF GREEN LED once the queue has drained */
+        if (UART_TX_IsIdle(port))
         {
-            HAL_GPIO_WritePin(GPIOD, GPIO_PIN_15, GPIO_PIN_SET);
-            HAL_Delay(100);
-            HAL_GPIO_WritePin(GPIOD, GPIO_PIN_15, GPIO_PIN_RESET);
-            HAL_Delay(100);
+            LED_Off(LED_GREEN);
         }
+
+        /* Blink BLUE LED 3 times to indicate transmission complete, played
+           from SysTick so this callback returns immediately */
+        LED_Blink(LED_BLUE, 3, 200);
+    }
+
+    /* Wake the main loop for work that waits on the TX queue */
+    Event_Post(EVT_TX_DONE);
+}
+
+/**
+  * @brief  UART reception event callback - half/full DMA buffer or IDLE line
+  * @param  huart: UART handle
+  * @param  Size: DMA write position in the reception buffer
+  * @retval None
+  */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    UART_RX_EventISR(UART_Port_FromHandle(huart), Size);
+}
+
+/**
+  * @brief  Received data callback - each port's bytes go through its own
+  *         command parser; see cmd.c for the commands
+  * @param  port: UART port the bytes arrived on
+  * @param  data: received bytes, valid until return
+  * @param  len: number of bytes
+  * @param  t_us: time of the DMA event that reported them
+  * @retval None
+  */
+void UART_RX_DataCallback(UART_PortTypeDef port, const uint8_t *data, uint16_t len,
+                          uint32_t t_us)
+{
+    uint32_t lat = Timebase_Since(t_us);
+
+    if (lat > rx_lat_max_us[port])
+    {
+        rx_lat_max_us[port] = lat;
+    }
+
+    /* HC-05 answers while an AT command is pending */
+    if (port == UART_PORT_HC05)
+    {
+        HC05_RxFeed(data, len);
+    }
+
+    Cmd_Feed(&cmd_parser[port], data, len);
+}
+
+/**
+  * @brief  "help" - list the commands
+  * @param  arg: unused
+  * @param  len: unused
+  * @retval None
+  */
+void Cmd_OnHelp(const char *arg, uint16_t len)
+{
+    UNUSED(arg);
+    UNUSED(len);
+
+    Event_Post(EVT_HELP);
+}
+
+/**
+  * @brief  "msg <text>" - replace the message the button sends
+  * @param  arg: argument text, valid until return
+  * @param  len: argument length
+  * @retval None
+  */
+void Cmd_OnMsg(const char *arg, uint16_t len)
+{
+    if (len > TX_BUFSIZE - 2)
+    {
+        len = TX_BUFSIZE - 2;
+    }
+    memcpy(msg_next, arg, len);
+    msg_next[len] = '\r';
+    msg_next[len + 1] = '\n';
+    msg_next_len = len + 2;
+    Event_Post(EVT_SET_MSG);
+}
+
+/**
+  * @brief  "baud <rate>" - move the HC-05 link to another rate
+  * @param  arg: argument text, valid until return
+  * @param  len: argument length
+  * @retval None
+  */
+void Cmd_OnBaud(const char *arg, uint16_t len)
+{
+    uint32_t baud = 0;
+
+    for (uint16_t i = 0; i < len && arg[i] >= '0' && arg[i] <= '9'; i++)
+    {
+        baud = baud * 10U + (uint32_t)(arg[i] - '0');
+    }
+    if (baud != 0)
+    {
+        baud_next = baud;
+        Event_Post(EVT_SET_BAUD);
+    }
+}
+
+/**
+  * @brief  "stats" - queue, reception and logging counters
+  * @param  arg: unused
+  * @param  len: unused
+  * @retval None
+  */
+void Cmd_OnStats(const char *arg, uint16_t len)
+{
+    UNUSED(arg);
+    UNUSED(len);
+
+    Event_Post(EVT_STATS);
+}
+
+/**
+  * @brief  "events" or "E" - main loop latency and sleep share
+  * @param  arg: unused
+  * @param  len: unused
+  * @retval None
+  */
+void Cmd_OnEvents(const char *arg, uint16_t len)
+{
+    UNUSED(arg);
+    UNUSED(len);
+
+    Event_Post(EVT_EVENT_DUMP);
+}
+
+/**
+  * @brief  "prof" or "?" - interrupt profile
+  * @param  arg: unused
+  * @param  len: unused
+  * @retval None
+  */
+void Cmd_OnProf(const char *arg, uint16_t len)
+{
+    UNUSED(arg);
+    UNUSED(len);
+
+    if (IRQ_PROF_ENABLED)
+    {
+        Event_Post(EVT_PROF_DUMP);
+    }
+}
+
+/**
+  * @brief  "sweep" or "B" - throughput at every supported link rate
+  * @param  arg: unused
+  * @param  len: unused
+  * @retval None
+  */
+void Cmd_OnSweep(const char *arg, uint16_t len)
+{
+    UNUSED(arg);
+    UNUSED(len);
+
+    Event_Post(EVT_BAUD_SWEEP);
+}
+
+/**
+  * @brief  "bench" or "C" - DMA bus contention benchmark
+  * @param  arg: ignored
+  * @param  len: ignored
+  * @retval None
+  */
+void Cmd_OnBench(const char *arg, uint16_t len)
+{
+    UNUSED(arg);
+    UNUSED(len);
+    Event_Post(EVT_CONTENTION);
+}
+
+/**
+  * @brief  "txcost" - interrupt cycles per TX span on each TX path
+  * @param  arg: ignored
+  * @param  len: ignored
+  * @retval None
+  */
+void Cmd_OnTxCost(const char *arg, uint16_t len)
+{
+    UNUSED(arg);
+    UNUSED(len);
+    Event_Post(EVT_TX_COST);
+}
+
+/**
+  * @brief  UART error callback - the HAL aborts DMA reception on overrun,
+  *         framing or DMA errors, so restart the circular receiver; a TX
+  *         DMA error ends the transfer in flight, so drop its span and
+  *         move the queue on
+  * @param  huart: UART handle
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    UART_PortTypeDef port = UART_Port_FromHandle(huart);
+
+    UART_TX_ErrorISR(port);
+    if (huart->RxState == HAL_UART_STATE_READY)
+    {
+        UART_RX_Restart(port);
     }
 }
 
@@ -294,32 +693,243 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
         {
             return;
         }
+        TLOG("button after %lu ms", (unsigned long)(now - last_press));
         last_press = now;
-        
-        /* Check if DMA is not busy before starting new transmission */
-        if (!dma_tx_busy && tx_len > 0)
+        button_us = Timebase_Now();
+
+        /* The message is queued, or the stream toggled, from the main loop */
+#if BENCH_STREAM_ON_BUTTON
+        stream_ms_next = 0;
+        Event_Post(EVT_STREAM);
+#else
+        Event_Post(EVT_BUTTON);
+#endif
+    }
+}
+
+/**
+  * @brief  SPI transfer complete callback - one accelerometer sample is in
+  * @param  hspi: SPI handle
+  * @retval None
+  */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    Accel_TransferCompleteISR(hspi);
+}
+
+/**
+  * @brief  SPI error callback - the sample is lost, release the bus
+  * @param  hspi: SPI handle
+  * @retval None
+  */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    Accel_TransferCompleteISR(hspi);
+}
+
+/**
+  * @brief  A batch of accelerometer samples is ready, code and send it from
+  *         the main loop
+  * @param  None
+  * @retval None
+  */
+void Accel_ReadyCallback(void)
+{
+    Event_Post(EVT_ACCEL);
+}
+
+/**
+  * @brief  Tokenized log records are waiting, flush them from the main loop
+  * @param  None
+  * @retval None
+  */
+void TLog_ReadyCallback(void)
+{
+    Event_Post(EVT_TLOG);
+}
+
+/**
+  * @brief  "stream [seconds]" - start the pattern frame stream, or stop it
+  * @param  arg: argument text, valid until return
+  * @param  len: argument length
+  * @retval None
+  */
+void Cmd_OnStream(const char *arg, uint16_t len)
+{
+    uint32_t seconds = 0;
+
+    for (uint16_t i = 0; i < len && arg[i] >= '0' && arg[i] <= '9'; i++)
+    {
+        seconds = seconds * 10U + (uint32_t)(arg[i] - '0');
+    }
+    stream_ms_next = seconds * 1000U;
+    Event_Post(EVT_STREAM);
+}
+
+/**
+  * @brief  "accel [hz]" - stream accelerometer frames at hz samples per
+  *         second, or stop without an argument
+  * @param  arg: argument text, valid until return
+  * @param  len: argument length
+  * @retval None
+  */
+void Cmd_OnAccel(const char *arg, uint16_t len)
+{
+    uint32_t hz = 0;
+
+    for (uint16_t i = 0; i < len && arg[i] >= '0' && arg[i] <= '9'; i++)
+    {
+        hz = hz * 10U + (uint32_t)(arg[i] - '0');
+    }
+    accel_hz_next = hz;
+    Event_Post(EVT_SET_ACCEL);
+}
+
+/**
+  * @brief  Take over the message staged by "msg", from the main loop
+  * @param  None
+  * @retval HAL_BUSY while a port may still be reading the current message
+  */
+static HAL_StatusTypeDef Message_Apply(void)
+{
+    /* Only tx_buf can still be queued; a canned message is never
+       overwritten. Other traffic on the ports does not hold it back. */
+    for (uint32_t i = 0; (tx_msg == tx_buf) && (i < UART_PORT_COUNT); i++)
+    {
+        if ((int32_t)(UART_TX_ClassRetired((UART_PortTypeDef)i, UART_TX_URGENT) -
+                      tx_ticket[i]) < 0)
         {
-            dma_tx_busy = true;
-            
-            /* Turn ON GREEN LED to indicate transmission started */
-            HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_SET);
-            
-            /* Start DMA transmission */
-            if (HAL_UART_Transmit_DMA(&huart6, tx_buf, tx_len) != HAL_OK)
-            {
-                /* Error - turn off GREEN, blink RED rapidly */
-                dma_tx_busy = false;
-                HAL_GPIO_WritePin(GPIOD, GPIO_PIN_12, GPIO_PIN_RESET);
-                
-                for (int i = 0; i < 5; i++)
-                {
-                    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_SET);
-                    HAL_Delay(100);
-                    HAL_GPIO_WritePin(GPIOD, GPIO_PIN_14, GPIO_PIN_RESET);
-                    HAL_Delay(100);
-                }
-            }
+            return HAL_BUSY;
+        }
+    }
+
+    /* Keep a second "msg" from changing the text halfway */
+    __disable_irq();
+    tx_len = msg_next_len;
+    memcpy(tx_buf, msg_next, tx_len);
+    tx_msg = tx_buf;
+    __enable_irq();
+
+    /* Nothing queued from the new text yet */
+    for (uint32_t i = 0; i < UART_PORT_COUNT; i++)
+    {
+        tx_ticket[i] = UART_TX_ClassRetired((UART_PortTypeDef)i, UART_TX_URGENT);
+    }
+
+    return HAL_OK;
+}
+
+/**
+  * @brief  Print the per-port queue and reception counters and the logging
+  *         and command statistics, from the main loop
+  * @param  None
+  * @retval None
+  */
+static void Stats_Print(void)
+{
+    UART_TX_StatsTypeDef tx;
+    UART_Log_StatsTypeDef log;
+    TLog_StatsTypeDef tlog;
+    UART_Pool_StatsTypeDef pool;
+    Accel_StatsTypeDef accel;
+
+    for (uint32_t i = 0; i < UART_PORT_COUNT; i++)
+    {
+        const Cmd_StatsTypeDef *cmd = &cmd_parser[i].stats;
+
+        UART_TX_GetStats((UART_PortTypeDef)i, &tx);
+        printf("port %lu tx queued=%lu done=%lu rejected=%lu errors=%lu depth=%u "
+               "urgent=%lu preempted=%lu latency avg=%lu max=%lu us "
+               "rx restarts=%lu latency max=%lu us "
+               "cmd lines=%lu ok=%lu unknown=%lu carried=%lu\r\n",
+               (unsigned long)i, (unsigned long)tx.queued, (unsigned long)tx.completed,
+               (unsigned long)tx.rejected, (unsigned long)tx.errors, tx.max_depth,
+               (unsigned long)tx.urgent, (unsigned long)tx.preempted,
+               (unsigned long)((tx.completed != 0) ? tx.lat_sum_us / tx.completed : 0U),
+               (unsigned long)tx.lat_max_us,
+               (unsigned long)UART_RX_GetRestarts((UART_PortTypeDef)i),
+               (unsigned long)rx_lat_max_us[i],
+               (unsigned long)cmd->lines, (unsigned long)cmd->dispatched,
+               (unsigned long)cmd->unknown, (unsigned long)cmd->carried);
+    }
+
+    UART_Log_GetStats(&log);
+    TLog_GetStats(&tlog);
+    printf("log written=%lu dropped=%lu overwritten=%lu tlog records=%lu dropped=%lu "
+           "packets=%lu\r\n",
+           (unsigned long)log.written, (unsigned long)log.dropped,
+           (unsigned long)log.overwritten, (unsigned long)tlog.records,
+           (unsigned long)tlog.dropped, (unsigned long)tlog.packets);
+
+    UART_Pool_GetStats(&pool);
+    printf("pool blocks=%u in use=%lu high water=%lu allocated=%lu failed=%lu\r\n",
+           (unsigned)UART_POOL_BLOCKS, (unsigned long)pool.in_use,
+           (unsigned long)pool.high_water, (unsigned long)pool.allocated,
+           (unsigned long)pool.failed);
+
+    /* Raw samples are 6 bytes, compare with the coded frame bytes */
+    Accel_GetStats(&accel);
+    printf("accel %s rate=%lu Hz samples=%lu dropped=%lu overruns=%lu frames=%lu "
+           "bytes=%lu raw=%lu\r\n",
+           Accel_IsRunning() ? "on" : "off", (unsigned long)accel.rate_hz,
+           (unsigned long)accel.samples, (unsigned long)accel.dropped,
+           (unsigned long)accel.overruns, (unsigned long)accel.frames,
+           (unsigned long)accel.bytes, (unsigned long)(accel.samples * 6U));
+
+#if UART_FLOW_CONTROL
+    {
+        UART_Flow_StatsTypeDef flow;
+
+        UART_Flow_GetStats(&flow);
+        printf("flow stalls=%lu stalled=%lu ms max=%lu us\r\n",
+               (unsigned long)flow.stalls, (unsigned long)(flow.stalled_us / 1000U),
+               (unsigned long)flow.max_stall_us);
+    }
+#endif
+}
+
+/**
+  * @brief  Send the button message on every port, from the main loop
+  * @param  None
+  * @retval None
+  */
+static void Button_Send(void)
+{
+    bool failed = false;
+
+    if (tx_len == 0)
+    {
+        return;
+    }
+
+    /* Turn ON GREEN LED to indicate transmission started */
+    LED_On(LED_GREEN);
+
+    /* Queue the message as urgent: it starts at once if the line is idle,
+       or right after the bulk chunk in flight, ahead of pending logs and
+       stream frames. The ports only read the message, so they can share
+       it. */
+    for (uint32_t i = 0; i < UART_PORT_COUNT; i++)
+    {
+        if (UART_TX_SendUrgent((UART_PortTypeDef)i, tx_msg, tx_len) != HAL_OK)
+        {
+            failed = true;
+        }
+        else if (tx_msg == tx_buf)
+        {
+            tx_ticket[i] = UART_TX_ClassQueued((UART_PortTypeDef)i, UART_TX_URGENT);
+        }
+    }
+    TLOG("button queued %lu us after the press", (unsigned long)Timebase_Since(button_us));
+
+    if (failed)
+    {
+        /* Queue full - blink RED rapidly */
+        if (UART_TX_IsIdle(UART_PORT_HC05))
+        {
+            LED_Off(LED_GREEN);
         }
+        LED_Blink(LED_RED, 5, 200);
     }
 }
 
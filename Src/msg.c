@@ -0,0 +1,48 @@
+/**
+  ******************************************************************************
+  * @file    Src/msg.c
+  * @brief   Canned messages sent straight from flash.
+  *
+  *          The texts listed in MSG_TABLE are const arrays, so they stay in
+  *          flash, and their lengths are sizeof - 1, so nothing is measured
+  *          or copied at run time. DMA2 reads flash through the bus matrix
+  *          like SRAM, so a canned message costs one TX queue entry and the
+  *          DMA re-arm; the RAM buffers stay free for text built at run time.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "msg.h"
+#include "uart_tx.h"
+
+/* Private variables ---------------------------------------------------------*/
+#define MSG_TEXT_(id, text) static const char id##_text[] = text;
+MSG_TABLE(MSG_TEXT_)
+#undef MSG_TEXT_
+
+/* Exported variables --------------------------------------------------------*/
+const Msg_EntryTypeDef msg_table[MSG_COUNT] =
+{
+#define MSG_ENTRY_(id, text) [id] = { (const uint8_t *)id##_text, sizeof(id##_text) - 1U },
+    MSG_TABLE(MSG_ENTRY_)
+#undef MSG_ENTRY_
+};
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Queue a canned message on a port
+  * @param  port: UART port to send on
+  * @param  id: message from MSG_TABLE
+  * @retval HAL_OK if queued, HAL_BUSY if the TX queue is full,
+  *         HAL_ERROR for an unknown id
+  */
+HAL_StatusTypeDef Msg_Send(UART_PortTypeDef port, Msg_IdTypeDef id)
+{
+    if ((uint32_t)id >= MSG_COUNT)
+    {
+        return HAL_ERROR;
+    }
+
+    return UART_TX_Send(port, msg_table[id].data, msg_table[id].len);
+}
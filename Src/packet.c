@@ -0,0 +1,162 @@
+/**
+  ******************************************************************************
+  * @file    Src/packet.c
+  * @brief   Packet framing on top of the UART TX queues.
+  *
+  *          Packets are COBS encoded in place and terminated by a zero byte,
+  *          so a receiver that loses a byte on the radio link drops one
+  *          packet and resynchronises on the next delimiter. Integrity is
+  *          checked with a CRC32 from the hardware CRC unit, fed one word at
+  *          a time. See packet.h for the exact frame and CRC definition.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "packet.h"
+#include "uart_tx.h"
+#include <string.h>
+
+/* Private variables ---------------------------------------------------------*/
+static CRC_HandleTypeDef hcrc;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Enable the CRC unit
+  * @param  None
+  * @retval None
+  */
+void Packet_Init(void)
+{
+    __HAL_RCC_CRC_CLK_ENABLE();
+    hcrc.Instance = CRC;
+    HAL_CRC_Init(&hcrc);
+}
+
+/**
+  * @brief  CRC32 of a word-aligned block with the hardware CRC unit
+  * @param  data: word-aligned data
+  * @param  len: length in bytes, the last partial word is zero-padded
+  * @retval CRC32 as defined in packet.h
+  */
+uint32_t Packet_CRC(const uint8_t *data, uint16_t len)
+{
+    uint32_t words = len / 4U;
+    uint32_t tail = 0;
+    uint32_t crc;
+
+    crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)data, words);
+    if ((len & 3U) != 0)
+    {
+        memcpy(&tail, &data[words * 4U], len & 3U);
+        crc = HAL_CRC_Accumulate(&hcrc, &tail, 1);
+    }
+    return crc;
+}
+
+/**
+  * @brief  Append the CRC and COBS encode a packet in place
+  * @param  buf: word-aligned buffer of PACKET_BUFSIZE(len) bytes with the
+  *              payload at PACKET_PAYLOAD(buf)
+  * @param  len: payload length, at most PACKET_MAX_PAYLOAD
+  * @param  frame: set to the first byte of the encoded frame
+  * @retval Frame length including the delimiter, 0 if len is too large
+  */
+uint16_t Packet_Encode(uint8_t *buf, uint16_t len, uint8_t **frame)
+{
+    uint8_t *p = PACKET_PAYLOAD(buf);
+    uint8_t *code = p - 1;
+    uint8_t *end;
+    uint32_t crc;
+
+    if (len > PACKET_MAX_PAYLOAD)
+    {
+        return 0;
+    }
+
+    crc = Packet_CRC(p, len);
+    end = p + len;
+    end[0] = (uint8_t)crc;
+    end[1] = (uint8_t)(crc >> 8);
+    end[2] = (uint8_t)(crc >> 16);
+    end[3] = (uint8_t)(crc >> 24);
+    end += 4;
+
+    /* Every zero becomes the code byte of the block that follows it; the
+       previous code byte gets the distance to it */
+    for (; p < end; p++)
+    {
+        if (*p == 0)
+        {
+            *code = (uint8_t)(p - code);
+            code = p;
+        }
+    }
+    *code = (uint8_t)(end - code);
+    *end = PACKET_DELIMITER;
+
+    *frame = PACKET_PAYLOAD(buf) - 1;
+    return (uint16_t)(end + 1 - *frame);
+}
+
+/**
+  * @brief  Encode a packet and queue it for transmission
+  * @param  port: UART port to send on
+  * @param  buf: packet buffer, see Packet_Encode(); must stay untouched until
+  *              the frame has been sent
+  * @param  len: payload length
+  * @retval HAL_ERROR if len is too large, otherwise the TX queue status
+  */
+HAL_StatusTypeDef Packet_Send(UART_PortTypeDef port, uint8_t *buf, uint16_t len)
+{
+    uint8_t *frame;
+    uint16_t frame_len = Packet_Encode(buf, len, &frame);
+
+    if (frame_len == 0)
+    {
+        return HAL_ERROR;
+    }
+    return UART_TX_Send(port, frame, frame_len);
+}
+
+/**
+  * @brief  Decode a received frame in place and check its CRC
+  * @param  frame: word-aligned encoded bytes without the delimiter; the
+  *                payload is written back starting at frame[0]
+  * @param  len: number of encoded bytes
+  * @retval Payload length, or -1 on malformed frame or CRC mismatch
+  */
+int32_t Packet_Decode(uint8_t *frame, uint16_t len)
+{
+    uint16_t in = 0;
+    uint16_t out = 0;
+    uint32_t crc;
+
+    while (in < len)
+    {
+        uint8_t code = frame[in++];
+
+        if (code == 0 || in + code - 1 > len)
+        {
+            return -1;
+        }
+        for (uint8_t i = 1; i < code; i++)
+        {
+            frame[out++] = frame[in++];
+        }
+        if (code != 0xFF && in < len)
+        {
+            frame[out++] = 0;
+        }
+    }
+
+    if (out < 4)
+    {
+        return -1;
+    }
+    out -= 4;
+    crc = (uint32_t)frame[out] | ((uint32_t)frame[out + 1] << 8) |
+          ((uint32_t)frame[out + 2] << 16) | ((uint32_t)frame[out + 3] << 24);
+
+    return (Packet_CRC(frame, out) == crc) ? (int32_t)out : -1;
+}
@@ -21,6 +21,13 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 #include "stm32f4xx_it.h"
+#include "led.h"
+#include "irq_prof.h"
+#include "uart_flow.h"
+#include "uart_port.h"
+#include "defer.h"
+#include "accel.h"
+#include "mem_sections.h"
 
 /** @addtogroup STM32F4xx_HAL_Examples
   * @{
@@ -31,9 +38,6 @@
   */
 
 /* Private typedef -----------------------------------------------------------*/
-extern DMA_HandleTypeDef hdma_usart6_tx;
- extern UART_HandleTypeDef huart6;
-
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables --------------------------------------------------------*/
@@ -41,6 +45,7 @@ extern DMA_HandleTypeDef hdma_usart6_tx;
 /* Private function prototypes -----------------------------------------------*/
 
  void DMA2_Stream6_IRQHandler(void);
+ void DMA2_Stream1_IRQHandler(void);
  void EXTI0_IRQHandler(void);
 
 void USART6_IRQHandler(void);  /* ADD THIS LINE - Function prototype */
@@ -137,6 +142,12 @@ void DebugMon_Handler(void)
   */
 void PendSV_Handler(void)
 {
+  IRQ_PROF_ENTER(IRQ_PROF_PENDSV);
+
+  /* Work queued by the interrupt handlers, at the lowest priority */
+  Defer_IRQHandler();
+
+  IRQ_PROF_EXIT(IRQ_PROF_PENDSV);
 }
 
 /**
@@ -146,7 +157,15 @@ void PendSV_Handler(void)
   */
 void SysTick_Handler(void)
 {
+  IRQ_PROF_ENTER(IRQ_PROF_SYSTICK);
+  /* SysTick counts down from LOAD and pends on reload, so LOAD - VAL is the
+     number of cycles elapsed since the event */
+  IRQ_PROF_LATENCY(IRQ_PROF_SYSTICK, SysTick->LOAD - SysTick->VAL);
+
   HAL_IncTick();
+  LED_TickISR();
+
+  IRQ_PROF_EXIT(IRQ_PROF_SYSTICK);
 }
 
 /******************************************************************************/
@@ -161,21 +180,147 @@ void SysTick_Handler(void)
   * @param  None
   * @retval None
   */
-void DMA2_Stream6_IRQHandler(void)
+#if UART_PORT_USE_USART6
+RAMFUNC void DMA2_Stream6_IRQHandler(void)
+{
+    IRQ_PROF_ENTER(IRQ_PROF_DMA2_STREAM6);
+    UART_Port_TxDMA_IRQHandler(UART_PORT_USART6);
+    IRQ_PROF_EXIT(IRQ_PROF_DMA2_STREAM6);
+}
+
+RAMFUNC void DMA2_Stream1_IRQHandler(void)
 {
-    HAL_DMA_IRQHandler(&hdma_usart6_tx);
+    IRQ_PROF_ENTER(IRQ_PROF_DMA2_STREAM1);
+    HAL_DMA_IRQHandler(&uart_port_hdmarx[UART_PORT_USART6]);
+    IRQ_PROF_EXIT(IRQ_PROF_DMA2_STREAM1);
 }
+#endif
 
 void EXTI0_IRQHandler(void)
 {
+    IRQ_PROF_ENTER(IRQ_PROF_EXTI0);
     HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_0);
+    IRQ_PROF_EXIT(IRQ_PROF_EXTI0);
 }
 
+/* LIS3DSH telemetry: sample timer and the SPI1 RX/TX DMA streams */
+void TIM3_IRQHandler(void)
+{
+    IRQ_PROF_ENTER(IRQ_PROF_TIM3);
+    Accel_TIM_IRQHandler();
+    IRQ_PROF_EXIT(IRQ_PROF_TIM3);
+}
+
+void DMA2_Stream0_IRQHandler(void)
+{
+    IRQ_PROF_ENTER(IRQ_PROF_DMA2_STREAM0);
+    Accel_DMA_RX_IRQHandler();
+    IRQ_PROF_EXIT(IRQ_PROF_DMA2_STREAM0);
+}
+
+void DMA2_Stream3_IRQHandler(void)
+{
+    IRQ_PROF_ENTER(IRQ_PROF_DMA2_STREAM3);
+    Accel_DMA_TX_IRQHandler();
+    IRQ_PROF_EXIT(IRQ_PROF_DMA2_STREAM3);
+}
+
+#if UART_PORT_USE_USART6
+RAMFUNC void USART6_IRQHandler(void)
+{
+    IRQ_PROF_ENTER(IRQ_PROF_USART6);
+    HAL_UART_IRQHandler(UART_Port_Handle(UART_PORT_USART6));
+    IRQ_PROF_EXIT(IRQ_PROF_USART6);
+}
+#endif
+
+/* Further links of the UART port table: USART, TX DMA and RX DMA stream
+   interrupts, each with its port as a constant */
+#if UART_PORT_USE_USART1
+RAMFUNC void USART1_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(UART_Port_Handle(UART_PORT_USART1));
+}
+
+RAMFUNC void DMA2_Stream7_IRQHandler(void)
+{
+    UART_Port_TxDMA_IRQHandler(UART_PORT_USART1);
+}
+
+RAMFUNC void DMA2_Stream2_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&uart_port_hdmarx[UART_PORT_USART1]);
+}
+#endif
+
+#if UART_PORT_USE_USART2
+RAMFUNC void USART2_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(UART_Port_Handle(UART_PORT_USART2));
+}
+
+RAMFUNC void DMA1_Stream6_IRQHandler(void)
+{
+    UART_Port_TxDMA_IRQHandler(UART_PORT_USART2);
+}
+
+RAMFUNC void DMA1_Stream5_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&uart_port_hdmarx[UART_PORT_USART2]);
+}
+#endif
+
+#if UART_PORT_USE_USART3
+RAMFUNC void USART3_IRQHandler(void)
+{
+    UART_Flow_IRQHandler(UART_Port_Handle(UART_PORT_USART3));
+    HAL_UART_IRQHandler(UART_Port_Handle(UART_PORT_USART3));
+}
+
+RAMFUNC void DMA1_Stream3_IRQHandler(void)
+{
+    UART_Port_TxDMA_IRQHandler(UART_PORT_USART3);
+}
+
+RAMFUNC void DMA1_Stream1_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&uart_port_hdmarx[UART_PORT_USART3]);
+}
+#endif
+
+#if UART_PORT_USE_UART4
+RAMFUNC void UART4_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(UART_Port_Handle(UART_PORT_UART4));
+}
+
+RAMFUNC void DMA1_Stream4_IRQHandler(void)
+{
+    UART_Port_TxDMA_IRQHandler(UART_PORT_UART4);
+}
+
+RAMFUNC void DMA1_Stream2_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&uart_port_hdmarx[UART_PORT_UART4]);
+}
+#endif
+
+#if UART_PORT_USE_UART5
+RAMFUNC void UART5_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(UART_Port_Handle(UART_PORT_UART5));
+}
+
+RAMFUNC void DMA1_Stream7_IRQHandler(void)
+{
+    UART_Port_TxDMA_IRQHandler(UART_PORT_UART5);
+}
 
-void USART6_IRQHandler(void)
+RAMFUNC void DMA1_Stream0_IRQHandler(void)
 {
-    HAL_UART_IRQHandler(&huart6);
+    HAL_DMA_IRQHandler(&uart_port_hdmarx[UART_PORT_UART5]);
 }
+#endif
 /**
   * @}
   */ 
@@ -0,0 +1,60 @@
+/**
+  ******************************************************************************
+  * @file    Src/timebase.c
+  * @brief   Free-running microsecond time base on TIM2.
+  *
+  *          TIM2 is one of the two 32-bit timers of the F407. It is
+  *          prescaled to 1 MHz and left counting with the full 32-bit
+  *          auto-reload and no interrupt, so Timebase_Now() is a single
+  *          register read that works in any context, also with interrupts
+  *          masked, where HAL_GetTick() stops advancing. HAL_GetTick()
+  *          stays the millisecond clock for timeouts; this one time stamps
+  *          I/O events (TX submit and completion, RX spans, the button) and
+  *          frames.
+  *
+  *          The timer is stopped while the core is halted by a debugger, so
+  *          time stamps stay consistent with the code being stepped.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "timebase.h"
+
+/* Private variables ---------------------------------------------------------*/
+static TIM_HandleTypeDef timebase_htim;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Start TIM2 counting microseconds from zero. Call once the system
+  *         clock is configured.
+  * @param  None
+  * @retval HAL status
+  */
+HAL_StatusTypeDef Timebase_Init(void)
+{
+    uint32_t tim_clk = HAL_RCC_GetPCLK1Freq();
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    __HAL_DBGMCU_FREEZE_TIM2();
+
+    /* Timer clocks run at twice PCLK1 when APB1 is divided */
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
+    {
+        tim_clk *= 2U;
+    }
+    timebase_htim.Instance = TIMEBASE_TIM;
+    timebase_htim.Init.Prescaler = tim_clk / TIMEBASE_HZ - 1U;
+    timebase_htim.Init.CounterMode = TIM_COUNTERMODE_UP;
+    timebase_htim.Init.Period = 0xFFFFFFFFU;
+    timebase_htim.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    timebase_htim.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    if (HAL_TIM_Base_Init(&timebase_htim) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    /* HAL_TIM_Base_Init() loads the prescaler through an update event */
+    __HAL_TIM_SET_COUNTER(&timebase_htim, 0);
+    return HAL_TIM_Base_Start(&timebase_htim);
+}
@@ -0,0 +1,239 @@
+/**
+  ******************************************************************************
+  * @file    Src/tlog.c
+  * @brief   Tokenized binary logging.
+  *
+  *          TLOG() sends a token for its format string, a millisecond time
+  *          stamp and the raw argument values instead of formatted text; the
+  *          host rebuilds the message from the firmware ELF with
+  *          tools/tlog_decode.py. A typical line shrinks from 30-60 bytes of
+  *          text to 5-10 bytes, and the target does no formatting at all.
+  *
+  *          Records are appended, with interrupts briefly disabled, to one of
+  *          TLOG_BUFFERS packet buffers. TLog_Flush(), called from the main
+  *          loop, frames the finished buffers with Packet_Encode() and queues
+  *          them on the port. While nothing of ours is on the wire the buffer
+  *          being filled is closed at once, so an idle link sends each record
+  *          without delay and a busy one batches them. A buffer is given back
+  *          once UART_TX_Retired() passes the span count read when it was
+  *          queued.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "tlog.h"
+#include "packet.h"
+#include "uart_tx.h"
+#include "mem_sections.h"
+#include <string.h>
+#include <stdbool.h>
+
+/* Private define ------------------------------------------------------------*/
+#define TLOG_WORDS          ((PACKET_BUFSIZE(TLOG_PAYLOAD) + 3U) / 4U)
+#define TLOG_HEADER_MAX     (1U + 5U)
+#define TLOG_RECORD_MAX     (5U + 5U + 1U + 5U * TLOG_MAX_ARGS)
+#define TLOG_MASK           (TLOG_BUFFERS - 1U)
+
+#if (TLOG_BUFFERS & (TLOG_BUFFERS - 1)) != 0 || TLOG_BUFFERS < 2
+#error "TLOG_BUFFERS must be a power of two, at least 2"
+#endif
+#if TLOG_PAYLOAD > PACKET_MAX_PAYLOAD || TLOG_PAYLOAD < TLOG_HEADER_MAX + TLOG_RECORD_MAX
+#error "TLOG_PAYLOAD must hold one record and fit a packet"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+DMA_BUFFER static uint32_t tlog_buf[TLOG_BUFFERS][TLOG_WORDS];
+CCMRAM static uint16_t tlog_len[TLOG_BUFFERS];     /* payload bytes, 0 while empty */
+CCMRAM static uint32_t tlog_base[TLOG_BUFFERS];    /* tick of the first record */
+static uint8_t *tlog_frame[TLOG_BUFFERS];          /* encoded, not yet queued */
+static uint16_t tlog_frame_len[TLOG_BUFFERS];
+static uint32_t tlog_ticket[TLOG_BUFFERS];
+static volatile uint32_t tlog_fill;                 /* buffer taking records */
+static uint32_t tlog_sent;                          /* next buffer to queue */
+static volatile uint32_t tlog_retired;              /* oldest buffer not given back */
+CCMRAM static TLog_StatsTypeDef tlog_stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t TLog_Varint(uint8_t *p, uint32_t v);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Empty all buffers. Call before the first TLOG().
+  * @param  None
+  * @retval None
+  */
+void TLog_Init(void)
+{
+    for (uint32_t i = 0; i < TLOG_BUFFERS; i++)
+    {
+        tlog_len[i] = 0;
+        tlog_frame[i] = NULL;
+    }
+    tlog_fill = 0;
+    tlog_sent = 0;
+    tlog_retired = 0;
+    memset(&tlog_stats, 0, sizeof(tlog_stats));
+}
+
+/**
+  * @brief  Append one record, use the TLOG() macro instead. Safe from any
+  *         interrupt priority and from thread mode.
+  * @param  token: address of the format string
+  * @param  args: argument values
+  * @param  count: number of arguments, at most TLOG_MAX_ARGS are kept
+  * @retval None
+  */
+void TLog_Write(uint32_t token, const uint32_t *args, uint32_t count)
+{
+    uint8_t rec[TLOG_RECORD_MAX - 5U];
+    uint32_t now = HAL_GetTick();
+    uint32_t len;
+    uint32_t primask;
+    uint32_t b;
+    uint32_t used;
+    uint8_t *p;
+    bool wake = false;
+
+    /* Everything but the time offset is encoded before locking */
+    if (count > TLOG_MAX_ARGS)
+    {
+        count = TLOG_MAX_ARGS;
+    }
+    len = TLog_Varint(rec, token);
+    rec[len++] = (uint8_t)count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        len += TLog_Varint(&rec[len], args[i]);
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    b = tlog_fill & TLOG_MASK;
+    if (tlog_len[b] != 0 && tlog_len[b] + 5U + len > TLOG_PAYLOAD)
+    {
+        /* Current buffer is full, move on if the next one is free */
+        if (tlog_fill + 1U - tlog_retired >= TLOG_BUFFERS)
+        {
+            tlog_stats.dropped++;
+            __set_PRIMASK(primask);
+            return;
+        }
+        tlog_fill++;
+        b = tlog_fill & TLOG_MASK;
+        tlog_len[b] = 0;
+        wake = true;
+    }
+
+    p = (uint8_t *)tlog_buf[b] + PACKET_HEADROOM;
+    used = tlog_len[b];
+    if (used == 0)
+    {
+        tlog_base[b] = now;
+        p[0] = TLOG_PACKET_TYPE;
+        used = 1U + TLog_Varint(&p[1], now);
+        wake = true;
+    }
+    used += TLog_Varint(&p[used], now - tlog_base[b]);
+    memcpy(&p[used], rec, len);
+    tlog_len[b] = (uint16_t)(used + len);
+    tlog_stats.records++;
+
+    __set_PRIMASK(primask);
+
+    if (wake)
+    {
+        TLog_ReadyCallback();
+    }
+}
+
+/**
+  * @brief  Give back the buffers the DMA has sent and queue the finished
+  *         ones. Must be called from thread mode.
+  * @param  None
+  * @retval None
+  */
+void TLog_Flush(void)
+{
+    uint32_t retired = tlog_retired;
+    uint32_t b;
+
+    while (retired != tlog_sent &&
+           (int32_t)(UART_TX_Retired(TLOG_PORT) - tlog_ticket[retired & TLOG_MASK]) >= 0)
+    {
+        retired++;
+    }
+    tlog_retired = retired;
+
+    /* Nothing of ours on the wire: send what there is rather than wait */
+    __disable_irq();
+    if (tlog_sent == tlog_fill && retired == tlog_sent && tlog_len[tlog_fill & TLOG_MASK] != 0)
+    {
+        tlog_fill++;
+        tlog_len[tlog_fill & TLOG_MASK] = 0;
+    }
+    __enable_irq();
+
+    while (tlog_sent != tlog_fill)
+    {
+        b = tlog_sent & TLOG_MASK;
+
+        /* Encoding works in place, so it is done once even if the TX queue
+           is full and the frame has to wait for the next flush */
+        if (tlog_frame[b] == NULL)
+        {
+            tlog_frame_len[b] = Packet_Encode((uint8_t *)tlog_buf[b], tlog_len[b], &tlog_frame[b]);
+            tlog_stats.bytes += tlog_len[b];
+        }
+        if (UART_TX_Send(TLOG_PORT, tlog_frame[b], tlog_frame_len[b]) != HAL_OK)
+        {
+            break;
+        }
+        tlog_ticket[b] = UART_TX_Queued(TLOG_PORT);
+        tlog_frame[b] = NULL;
+        tlog_stats.packets++;
+        tlog_sent++;
+    }
+}
+
+/**
+  * @brief  Copy the logging statistics
+  * @param  stats: destination
+  * @retval None
+  */
+void TLog_GetStats(TLog_StatsTypeDef *stats)
+{
+    __disable_irq();
+    *stats = tlog_stats;
+    __enable_irq();
+}
+
+/**
+  * @brief  Records waiting callback, overridden by the application
+  * @param  None
+  * @retval None
+  */
+__weak void TLog_ReadyCallback(void)
+{
+}
+
+/**
+  * @brief  Write v as a little-endian base-128 varint
+  * @param  p: destination, room for 5 bytes
+  * @param  v: value
+  * @retval Bytes written
+  */
+static uint32_t TLog_Varint(uint8_t *p, uint32_t v)
+{
+    uint32_t n = 0;
+
+    while (v >= 0x80U)
+    {
+        p[n++] = (uint8_t)(v | 0x80U);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+
+    return n;
+}
@@ -0,0 +1,135 @@
+/**
+  ******************************************************************************
+  * @file    Src/uart_flow.c
+  * @brief   RTS/CTS flow control on USART3 with CTS stall accounting.
+  *
+  *          With UART_FLOW_CONTROL set, the USART itself stops sending while
+  *          the peer holds CTS high and raises RTS while its receive
+  *          register is full, so bytes are held instead of lost. The CTS
+  *          change interrupt (CTSIE) is used to time how long the
+  *          transmitter was held, in microseconds from the time base, since
+  *          a stall at 115200 baud can be shorter than one tick of
+  *          HAL_GetTick(); the HAL does not handle that flag, so
+  *          UART_Flow_IRQHandler() clears it before HAL_UART_IRQHandler()
+  *          runs. Senders see the stall as TX queue backpressure
+  *          (UART_TX_Send() returning HAL_BUSY) and can poll
+  *          UART_Flow_IsStalled().
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_flow.h"
+#include "uart_port.h"
+#include "timebase.h"
+#include "mem_sections.h"
+
+#if UART_FLOW_CONTROL
+
+#if !UART_PORT_USE_USART3
+#error "UART_FLOW_CONTROL needs USART3 (UART_PORT_USE_USART3=1)"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static volatile bool flow_stalled = false;
+static uint32_t flow_stall_start;   /* Timebase_Now() when CTS went high */
+CCMRAM static UART_Flow_StatsTypeDef flow_stats;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Configure the RTS/CTS pins and the CTS change interrupt. The UART
+  *         itself must be initialised with UART_FLOW_HWCONTROL.
+  * @param  huart: USART3 handle
+  * @retval None
+  */
+void UART_Flow_Init(UART_HandleTypeDef *huart)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    GPIO_InitStruct.Pin = UART_FLOW_RTS_PIN | UART_FLOW_CTS_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    GPIO_InitStruct.Alternate = UART_FLOW_AF;
+    HAL_GPIO_Init(UART_FLOW_GPIO_PORT, &GPIO_InitStruct);
+
+    flow_stalled = (HAL_GPIO_ReadPin(UART_FLOW_GPIO_PORT, UART_FLOW_CTS_PIN) == GPIO_PIN_SET);
+    flow_stall_start = Timebase_Now();
+
+    __HAL_UART_CLEAR_FLAG(huart, UART_FLAG_CTS);
+    __HAL_UART_ENABLE_IT(huart, UART_IT_CTS);
+}
+
+/**
+  * @brief  Account for a CTS edge. Called from USART3_IRQHandler() before
+  *         HAL_UART_IRQHandler().
+  * @param  huart: USART3 handle
+  * @retval None
+  */
+void UART_Flow_IRQHandler(UART_HandleTypeDef *huart)
+{
+    bool stalled;
+
+    if (!__HAL_UART_GET_FLAG(huart, UART_FLAG_CTS))
+    {
+        return;
+    }
+    __HAL_UART_CLEAR_FLAG(huart, UART_FLAG_CTS);
+
+    /* CTS is active low: high means the peer cannot take more data */
+    stalled = (HAL_GPIO_ReadPin(UART_FLOW_GPIO_PORT, UART_FLOW_CTS_PIN) == GPIO_PIN_SET);
+    if (stalled == flow_stalled)
+    {
+        return;
+    }
+
+    if (stalled)
+    {
+        flow_stats.stalls++;
+        flow_stall_start = Timebase_Now();
+    }
+    else
+    {
+        uint32_t elapsed = Timebase_Since(flow_stall_start);
+
+        flow_stats.stalled_us += elapsed;
+        if (elapsed > flow_stats.max_stall_us)
+        {
+            flow_stats.max_stall_us = elapsed;
+        }
+    }
+    flow_stalled = stalled;
+}
+
+/**
+  * @brief  Report whether the peer is currently holding CTS
+  * @param  None
+  * @retval true while the transmitter is stalled
+  */
+bool UART_Flow_IsStalled(void)
+{
+    return flow_stalled;
+}
+
+/**
+  * @brief  Copy the stall statistics, including a stall still in progress
+  * @param  stats: destination
+  * @retval None
+  */
+void UART_Flow_GetStats(UART_Flow_StatsTypeDef *stats)
+{
+    *stats = flow_stats;
+    if (flow_stalled)
+    {
+        uint32_t elapsed = Timebase_Since(flow_stall_start);
+
+        stats->stalled_us += elapsed;
+        if (elapsed > stats->max_stall_us)
+        {
+            stats->max_stall_us = elapsed;
+        }
+    }
+}
+
+#endif /* UART_FLOW_CONTROL */
@@ -0,0 +1,295 @@
+/**
+  ******************************************************************************
+  * @file    Src/uart_log.c
+  * @brief   stdout retargeted to a log ring drained by the TX DMA queue.
+  *
+  *          _write() (GCC/newlib) and __write() (IAR DLib) copy the text that
+  *          printf() formatted into a byte ring and hand the unsent part to
+  *          UART_TX_SendIov() as one or two spans, so a printf() costs the
+  *          formatting and a memcpy, never the time on the wire. The ring
+  *          lives in SRAM1 and the DMA reads it in place.
+  *
+  *          Only one region of the ring is with the TX queue at a time. Its
+  *          spans are identified by the port's span counter, and the region
+  *          is given back once UART_TX_Retired() has passed them. Text
+  *          written meanwhile collects behind it and goes out as the next
+  *          region; UART_Log_Flush() submits it and is called again from the
+  *          main loop after every TX completion.
+  *
+  *          Like any other sender of the port, writers must be in thread
+  *          mode: the TX queue takes a single producer context.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_log.h"
+#include "uart_tx.h"
+#include "mem_sections.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define LOG_MASK (UART_LOG_RING_SIZE - 1U)
+
+#if (UART_LOG_RING_SIZE & (UART_LOG_RING_SIZE - 1)) != 0 || UART_LOG_RING_SIZE > 32768
+#error "UART_LOG_RING_SIZE must be a power of two no larger than 32768"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+DMA_BUFFER static uint8_t log_ring[UART_LOG_RING_SIZE];
+static uint32_t log_head;       /* next byte to write */
+static uint32_t log_send;       /* first byte not handed to the TX queue */
+static uint32_t log_tail;       /* first byte the DMA may still read */
+static uint32_t log_ticket;     /* span count that retires the region in flight */
+static UART_Log_StatsTypeDef log_stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Log_Space(void);
+#if UART_LOG_POLICY == UART_LOG_POLICY_OVERWRITE
+static void Log_Discard(uint32_t need);
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Empty the ring and make stdout unbuffered, so each printf()
+  *         reaches the ring in one write. Call after UART_TX_Init().
+  * @param  None
+  * @retval None
+  */
+void UART_Log_Init(void)
+{
+    log_head = 0;
+    log_send = 0;
+    log_tail = 0;
+    log_ticket = 0;
+    memset(&log_stats, 0, sizeof(log_stats));
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+}
+
+/**
+  * @brief  Copy text into the ring and start sending it. Must be called from
+  *         thread mode.
+  * @param  data: text
+  * @param  len: number of bytes
+  * @retval len; bytes refused under the drop policy only show in the stats
+  */
+size_t UART_Log_Write(const char *data, size_t len)
+{
+    size_t left = len;
+    uint32_t used;
+
+    UART_Log_Flush();
+
+    while (left > 0)
+    {
+        uint32_t space = Log_Space();
+        uint32_t n;
+        uint32_t off;
+        uint32_t first;
+
+        if (space < left)
+        {
+#if UART_LOG_POLICY == UART_LOG_POLICY_BLOCK
+            if (space == 0)
+            {
+                /* The TX complete interrupt retires the region in flight */
+                log_stats.blocked++;
+                do
+                {
+                    UART_Log_Flush();
+                } while (Log_Space() == 0);
+                continue;
+            }
+#elif UART_LOG_POLICY == UART_LOG_POLICY_OVERWRITE
+            Log_Discard(left - space);
+            space = Log_Space();
+#else
+            /* Never put half a message on the wire */
+            space = 0;
+#endif
+        }
+
+        n = (space < left) ? space : (uint32_t)left;
+        if (n == 0)
+        {
+            log_stats.dropped += left;
+            break;
+        }
+
+        off = log_head & LOG_MASK;
+        first = UART_LOG_RING_SIZE - off;
+        if (first > n)
+        {
+            first = n;
+        }
+        memcpy(&log_ring[off], data, first);
+        memcpy(&log_ring[0], data + first, n - first);
+
+        log_head += n;
+        data += n;
+        left -= n;
+        log_stats.written += n;
+    }
+
+    used = log_head - log_tail;
+    if (used > log_stats.max_used)
+    {
+        log_stats.max_used = used;
+    }
+
+    UART_Log_Flush();
+
+    return len;
+}
+
+/**
+  * @brief  Take back the region the DMA has finished with and queue the text
+  *         written since. Must be called from thread mode.
+  * @param  None
+  * @retval None
+  */
+void UART_Log_Flush(void)
+{
+    UART_TX_IovTypeDef iov[2];
+    uint32_t len;
+    uint32_t off;
+
+    if (log_tail != log_send)
+    {
+        if ((int32_t)(UART_TX_Retired(UART_LOG_PORT) - log_ticket) < 0)
+        {
+            return;
+        }
+        log_tail = log_send;
+    }
+
+    len = log_head - log_send;
+    if (len == 0)
+    {
+        return;
+    }
+
+    /* Up to the end of the ring, then the wrapped part */
+    off = log_send & LOG_MASK;
+    iov[0].data = &log_ring[off];
+    iov[0].len = (uint16_t)((len < UART_LOG_RING_SIZE - off) ? len : UART_LOG_RING_SIZE - off);
+    iov[1].data = &log_ring[0];
+    iov[1].len = (uint16_t)(len - iov[0].len);
+
+    /* A full TX queue leaves the text here for the next flush */
+    if (UART_TX_SendIov(UART_LOG_PORT, iov, 2) == HAL_OK)
+    {
+        log_ticket = UART_TX_Queued(UART_LOG_PORT);
+        log_send = log_head;
+    }
+}
+
+/**
+  * @brief  Copy the log statistics
+  * @param  stats: destination
+  * @retval None
+  */
+void UART_Log_GetStats(UART_Log_StatsTypeDef *stats)
+{
+    *stats = log_stats;
+}
+
+/**
+  * @brief  Free bytes in the ring
+  * @param  None
+  * @retval Byte count
+  */
+static uint32_t Log_Space(void)
+{
+    return UART_LOG_RING_SIZE - (log_head - log_tail);
+}
+
+#if UART_LOG_POLICY == UART_LOG_POLICY_OVERWRITE
+/**
+  * @brief  Discard at least need bytes of the oldest unsent text, rounded up
+  *         to a whole line, and close the gap. The region the DMA is reading
+  *         is left alone.
+  * @param  need: bytes to free
+  * @retval None
+  */
+static void Log_Discard(uint32_t need)
+{
+    uint32_t unsent = log_head - log_send;
+    uint32_t k;
+
+    if (need >= unsent)
+    {
+        k = unsent;
+    }
+    else
+    {
+        /* Cut after the end of the line holding the last byte to go */
+        k = need;
+        while (k < unsent && log_ring[(log_send + k - 1U) & LOG_MASK] != '\n')
+        {
+            k++;
+        }
+    }
+    if (k == 0)
+    {
+        return;
+    }
+
+    for (uint32_t i = log_send; i + k != log_head; i++)
+    {
+        log_ring[i & LOG_MASK] = log_ring[(i + k) & LOG_MASK];
+    }
+    log_head -= k;
+    log_stats.overwritten += k;
+}
+#endif
+
+/* Retargeting ---------------------------------------------------------------*/
+#if defined(__ICCARM__)
+
+/**
+  * @brief  DLib low-level output, backs printf() and puts()
+  * @param  handle: 1 for stdout, 2 for stderr, -1 to flush
+  * @param  buffer: text
+  * @param  size: number of bytes
+  * @retval Bytes written, or -1 for other handles
+  */
+size_t __write(int handle, const unsigned char *buffer, size_t size)
+{
+    if (handle == -1)
+    {
+        UART_Log_Flush();
+        return 0;
+    }
+    if (handle != 1 && handle != 2)
+    {
+        return (size_t)-1;
+    }
+
+    return UART_Log_Write((const char *)buffer, size);
+}
+
+#elif defined(__GNUC__) && !defined(__ARMCC_VERSION)
+
+int _write(int file, char *ptr, int len);
+
+/**
+  * @brief  newlib system call, backs printf() and puts()
+  * @param  file: 1 for stdout, 2 for stderr
+  * @param  ptr: text
+  * @param  len: number of bytes
+  * @retval Bytes written, or -1 for other files
+  */
+int _write(int file, char *ptr, int len)
+{
+    if ((file != 1 && file != 2) || len < 0)
+    {
+        return -1;
+    }
+
+    return (int)UART_Log_Write(ptr, (size_t)len);
+}
+
+#endif
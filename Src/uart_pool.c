@@ -0,0 +1,159 @@
+/**
+  ******************************************************************************
+  * @file    Src/uart_pool.c
+  * @brief   Fixed-block pool of DMA-safe TX buffers.
+  *
+  *          A producer takes a block with UART_Pool_Alloc(), writes its
+  *          payload in place and hands it to UART_Pool_Send(). From then on
+  *          the block belongs to the TX queue, which returns it to the pool
+  *          when the span retires, from the DMA completion interrupt. No
+  *          heap is involved and no payload is copied.
+  *
+  *          Free blocks are the set bits of one word. Alloc clears the
+  *          lowest set bit and Free sets it again, each with LDREX/STREX, so
+  *          both are O(1) and safe from thread mode and any interrupt.
+  *
+  *          The TX queue releases a span that starts at a pool block,
+  *          whoever queued it, so a block must be queued once, on one port.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_pool.h"
+#include "uart_tx.h"
+#include "mem_sections.h"
+
+/* Private define ------------------------------------------------------------*/
+#define POOL_ALL_FREE   ((UART_POOL_BLOCKS == 32) ? 0xFFFFFFFFUL : ((1UL << UART_POOL_BLOCKS) - 1UL))
+
+/* Private variables ---------------------------------------------------------*/
+DMA_BUFFER static uint8_t pool_mem[UART_POOL_BLOCKS][UART_POOL_BLOCK_SIZE];
+CCMRAM static volatile uint32_t pool_free;
+CCMRAM static volatile uint32_t pool_in_use;
+CCMRAM static UART_Pool_StatsTypeDef pool_stats;
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Mark every block free
+  * @param  None
+  * @retval None
+  */
+void UART_Pool_Init(void)
+{
+    pool_free = POOL_ALL_FREE;
+    pool_in_use = 0;
+    pool_stats.allocated = 0;
+    pool_stats.failed = 0;
+    pool_stats.in_use = 0;
+    pool_stats.high_water = 0;
+}
+
+/**
+  * @brief  Take a block, from any context
+  * @param  None
+  * @retval UART_POOL_BLOCK_SIZE bytes, 16-byte aligned in SRAM1, or NULL if
+  *         every block is taken
+  */
+RAMFUNC uint8_t *UART_Pool_Alloc(void)
+{
+    uint32_t map;
+    uint32_t index;
+    uint32_t used;
+
+    do
+    {
+        map = __LDREXW(&pool_free);
+        if (map == 0U)
+        {
+            __CLREX();
+            pool_stats.failed++;
+            return NULL;
+        }
+        index = __CLZ(__RBIT(map));
+    } while (__STREXW(map & ~(1UL << index), &pool_free) != 0U);
+
+    do
+    {
+        used = __LDREXW(&pool_in_use) + 1U;
+    } while (__STREXW(used, &pool_in_use) != 0U);
+
+    pool_stats.allocated++;
+    if (used > pool_stats.high_water)
+    {
+        pool_stats.high_water = used;
+    }
+
+    return pool_mem[index];
+}
+
+/**
+  * @brief  Give a block back, from any context. Called by the TX queue for
+  *         every span it retires, so anything that is not the start of a
+  *         pool block is ignored.
+  * @param  block: pointer from UART_Pool_Alloc()
+  * @retval None
+  */
+RAMFUNC void UART_Pool_Free(const uint8_t *block)
+{
+    uint32_t offset = (uint32_t)((uintptr_t)block - (uintptr_t)pool_mem);
+    uint32_t index = offset / UART_POOL_BLOCK_SIZE;
+    uint32_t map;
+
+    /* Below the pool the offset wraps to a huge value */
+    if (index >= UART_POOL_BLOCKS || (offset % UART_POOL_BLOCK_SIZE) != 0U)
+    {
+        return;
+    }
+
+    do
+    {
+        map = __LDREXW(&pool_free);
+        if (map & (1UL << index))
+        {
+            /* Already free */
+            __CLREX();
+            return;
+        }
+    } while (__STREXW(map | (1UL << index), &pool_free) != 0U);
+
+    do
+    {
+        map = __LDREXW(&pool_in_use);
+    } while (__STREXW(map - 1U, &pool_in_use) != 0U);
+}
+
+/**
+  * @brief  Queue a filled block; the TX queue frees it once it is sent
+  * @param  port: UART port
+  * @param  block: block from UART_Pool_Alloc()
+  * @param  len: payload bytes, at most UART_POOL_BLOCK_SIZE
+  * @retval HAL_OK if queued; otherwise the status of UART_TX_Send() and the
+  *         block still belongs to the caller
+  */
+HAL_StatusTypeDef UART_Pool_Send(UART_PortTypeDef port, uint8_t *block, uint16_t len)
+{
+    if (len > UART_POOL_BLOCK_SIZE)
+    {
+        return HAL_ERROR;
+    }
+    if (len == 0U)
+    {
+        /* Nothing is queued, so nothing would free it */
+        UART_Pool_Free(block);
+        return HAL_OK;
+    }
+
+    return UART_TX_Send(port, block, len);
+}
+
+/**
+  * @brief  Copy the pool statistics
+  * @param  stats: destination
+  * @retval None
+  */
+void UART_Pool_GetStats(UART_Pool_StatsTypeDef *stats)
+{
+    *stats = pool_stats;
+    stats->in_use = pool_in_use;
+}
@@ -0,0 +1,269 @@
+/**
+  ******************************************************************************
+  * @file    Src/uart_port.c
+  * @brief   Table of the UART links and their DMA streams.
+  *
+  *          Every enabled link has a slot in uart_port_huart[] and the two
+  *          DMA handle arrays, indexed by its UART_PortTypeDef. The set of
+  *          links is fixed at compile time, so a port that is a constant at
+  *          the call site (every interrupt handler) resolves to fixed
+  *          addresses, and the TX/RX modules keep each port's state in one
+  *          struct reached through a single base register.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_port.h"
+#include "uart_flow.h"
+#include "uart_stream.h"
+#include "uart_tx.h"
+#include "mem_sections.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+    USART_TypeDef *instance;
+    IRQn_Type irqn;
+    DMA_Stream_TypeDef *tx_stream;
+    IRQn_Type tx_irqn;
+    DMA_Stream_TypeDef *rx_stream;
+    IRQn_Type rx_irqn;
+    uint32_t channel;           /* same request channel for TX and RX */
+    GPIO_TypeDef *tx_gpio;
+    uint16_t tx_pin;
+    GPIO_TypeDef *rx_gpio;
+    uint16_t rx_pin;
+    uint8_t af;
+    uint32_t hw_flow;
+} UART_PortConfigTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+UART_HandleTypeDef uart_port_huart[UART_PORT_COUNT];
+DMA_HandleTypeDef uart_port_hdmatx[UART_PORT_COUNT];
+DMA_HandleTypeDef uart_port_hdmarx[UART_PORT_COUNT];
+
+/* In UART_PortTypeDef order */
+static const UART_PortConfigTypeDef uart_port_config[UART_PORT_COUNT] =
+{
+#if UART_PORT_USE_USART1
+    { USART1, USART1_IRQn, DMA2_Stream7, DMA2_Stream7_IRQn, DMA2_Stream2, DMA2_Stream2_IRQn,
+      DMA_CHANNEL_4, GPIOB, GPIO_PIN_6, GPIOB, GPIO_PIN_7, GPIO_AF7_USART1, UART_HWCONTROL_NONE },
+#endif
+#if UART_PORT_USE_USART2
+    { USART2, USART2_IRQn, DMA1_Stream6, DMA1_Stream6_IRQn, DMA1_Stream5, DMA1_Stream5_IRQn,
+      DMA_CHANNEL_4, GPIOA, GPIO_PIN_2, GPIOA, GPIO_PIN_3, GPIO_AF7_USART2, UART_HWCONTROL_NONE },
+#endif
+#if UART_PORT_USE_USART3
+    { USART3, USART3_IRQn, DMA1_Stream3, DMA1_Stream3_IRQn, DMA1_Stream1, DMA1_Stream1_IRQn,
+      DMA_CHANNEL_4, GPIOD, GPIO_PIN_8, GPIOD, GPIO_PIN_9, GPIO_AF7_USART3, UART_FLOW_HWCONTROL },
+#endif
+#if UART_PORT_USE_UART4
+    { UART4, UART4_IRQn, DMA1_Stream4, DMA1_Stream4_IRQn, DMA1_Stream2, DMA1_Stream2_IRQn,
+      DMA_CHANNEL_4, GPIOC, GPIO_PIN_10, GPIOC, GPIO_PIN_11, GPIO_AF8_UART4, UART_HWCONTROL_NONE },
+#endif
+#if UART_PORT_USE_UART5
+    { UART5, UART5_IRQn, DMA1_Stream7, DMA1_Stream7_IRQn, DMA1_Stream0, DMA1_Stream0_IRQn,
+      DMA_CHANNEL_4, GPIOC, GPIO_PIN_12, GPIOD, GPIO_PIN_2, GPIO_AF8_UART5, UART_HWCONTROL_NONE },
+#endif
+#if UART_PORT_USE_USART6
+    { USART6, USART6_IRQn, DMA2_Stream6, DMA2_Stream6_IRQn, DMA2_Stream1, DMA2_Stream1_IRQn,
+      DMA_CHANNEL_5, GPIOC, GPIO_PIN_6, GPIOC, GPIO_PIN_7, GPIO_AF8_USART6, UART_HWCONTROL_NONE },
+#endif
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void Port_EnableClocks(const UART_PortConfigTypeDef *cfg);
+static void Port_EnableGPIOClock(GPIO_TypeDef *gpio);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Bring up one link: clocks, pins, both DMA streams, the USART and
+  *         the interrupts. The TX DMA is normal mode, the RX DMA circular.
+  * @param  port: link to initialise
+  * @param  baudrate: line rate
+  * @retval HAL status
+  */
+HAL_StatusTypeDef UART_Port_Init(UART_PortTypeDef port, uint32_t baudrate)
+{
+    const UART_PortConfigTypeDef *cfg = &uart_port_config[port];
+    UART_HandleTypeDef *huart = &uart_port_huart[port];
+    DMA_HandleTypeDef *hdmatx = &uart_port_hdmatx[port];
+    DMA_HandleTypeDef *hdmarx = &uart_port_hdmarx[port];
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    Port_EnableClocks(cfg);
+
+    /* TX and RX pins */
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    GPIO_InitStruct.Alternate = cfg->af;
+    GPIO_InitStruct.Pin = cfg->tx_pin;
+    HAL_GPIO_Init(cfg->tx_gpio, &GPIO_InitStruct);
+    GPIO_InitStruct.Pin = cfg->rx_pin;
+    HAL_GPIO_Init(cfg->rx_gpio, &GPIO_InitStruct);
+
+    /* TX DMA stream */
+    hdmatx->Instance = cfg->tx_stream;
+    hdmatx->Init.Channel = cfg->channel;
+    hdmatx->Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdmatx->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdmatx->Init.MemInc = DMA_MINC_ENABLE;
+    hdmatx->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdmatx->Init.Mode = DMA_NORMAL;
+    hdmatx->Init.Priority = DMA_PRIORITY_LOW;
+#if UART_TX_DMA_FIFO
+    /* FIFO with word-wide 4-beat memory bursts: one AHB burst per 16 bytes.
+       The TX queue switches to single bytes for unaligned heads and tails */
+    hdmatx->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdmatx->Init.FIFOMode = DMA_FIFOMODE_ENABLE;
+    hdmatx->Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+    hdmatx->Init.MemBurst = DMA_MBURST_INC4;
+    hdmatx->Init.PeriphBurst = DMA_PBURST_SINGLE;
+#else
+    hdmatx->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdmatx->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+#endif
+    if (HAL_DMA_Init(hdmatx) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    /* RX DMA stream, circular so the receiver never has to be re-armed */
+    hdmarx->Instance = cfg->rx_stream;
+    hdmarx->Init.Channel = cfg->channel;
+    hdmarx->Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdmarx->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdmarx->Init.MemInc = DMA_MINC_ENABLE;
+    hdmarx->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdmarx->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdmarx->Init.Mode = DMA_CIRCULAR;
+    hdmarx->Init.Priority = DMA_PRIORITY_MEDIUM;
+    hdmarx->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(hdmarx) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    huart->Instance = cfg->instance;
+    huart->Init.BaudRate = baudrate;
+    huart->Init.WordLength = UART_WORDLENGTH_8B;
+    huart->Init.StopBits = UART_STOPBITS_1;
+    huart->Init.Parity = UART_PARITY_NONE;
+    huart->Init.Mode = UART_MODE_TX_RX;
+    huart->Init.HwFlowCtl = cfg->hw_flow;
+    huart->Init.OverSampling = UART_OVERSAMPLING_16;
+    if (HAL_UART_Init(huart) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    __HAL_LINKDMA(huart, hdmatx, *hdmatx);
+    __HAL_LINKDMA(huart, hdmarx, *hdmarx);
+
+    /* RTS/CTS pins and CTS stall accounting, USART3 only */
+    if (cfg->hw_flow != UART_HWCONTROL_NONE)
+    {
+        UART_Flow_Init(huart);
+    }
+
+    /* USART interrupt for TC and IDLE, both DMA stream interrupts */
+    HAL_NVIC_SetPriority(cfg->tx_irqn, 5, 0);
+    HAL_NVIC_EnableIRQ(cfg->tx_irqn);
+    HAL_NVIC_SetPriority(cfg->rx_irqn, 5, 0);
+    HAL_NVIC_EnableIRQ(cfg->rx_irqn);
+    HAL_NVIC_SetPriority(cfg->irqn, 5, 0);
+    HAL_NVIC_EnableIRQ(cfg->irqn);
+
+    return HAL_OK;
+}
+
+/**
+  * @brief  TX DMA stream interrupt of a port. The queue drives the stream
+  *         itself on the fast path, except while the port is streaming.
+  * @param  port: link whose TX stream interrupted
+  * @retval None
+  */
+RAMFUNC void UART_Port_TxDMA_IRQHandler(UART_PortTypeDef port)
+{
+#if UART_TX_FASTPATH
+    if (UART_TX_IsFastPath(port) && !UART_Stream_IsRunning(port))
+    {
+        UART_TX_DMA_IRQHandler(port);
+        return;
+    }
+#endif
+    HAL_DMA_IRQHandler(&uart_port_hdmatx[port]);
+}
+
+/**
+  * @brief  Enable the USART, DMA controller and GPIO clocks of a port
+  * @param  cfg: port configuration
+  * @retval None
+  */
+static void Port_EnableClocks(const UART_PortConfigTypeDef *cfg)
+{
+    if (cfg->instance == USART1)
+    {
+        __HAL_RCC_USART1_CLK_ENABLE();
+    }
+    else if (cfg->instance == USART2)
+    {
+        __HAL_RCC_USART2_CLK_ENABLE();
+    }
+    else if (cfg->instance == USART3)
+    {
+        __HAL_RCC_USART3_CLK_ENABLE();
+    }
+    else if (cfg->instance == UART4)
+    {
+        __HAL_RCC_UART4_CLK_ENABLE();
+    }
+    else if (cfg->instance == UART5)
+    {
+        __HAL_RCC_UART5_CLK_ENABLE();
+    }
+    else
+    {
+        __HAL_RCC_USART6_CLK_ENABLE();
+    }
+
+    /* USART1 and USART6 are served by DMA2, the others by DMA1 */
+    if (cfg->instance == USART1 || cfg->instance == USART6)
+    {
+        __HAL_RCC_DMA2_CLK_ENABLE();
+    }
+    else
+    {
+        __HAL_RCC_DMA1_CLK_ENABLE();
+    }
+
+    Port_EnableGPIOClock(cfg->tx_gpio);
+    Port_EnableGPIOClock(cfg->rx_gpio);
+}
+
+/**
+  * @brief  Enable the clock of one of the GPIO ports used by the table
+  * @param  gpio: GPIO port
+  * @retval None
+  */
+static void Port_EnableGPIOClock(GPIO_TypeDef *gpio)
+{
+    if (gpio == GPIOA)
+    {
+        __HAL_RCC_GPIOA_CLK_ENABLE();
+    }
+    else if (gpio == GPIOB)
+    {
+        __HAL_RCC_GPIOB_CLK_ENABLE();
+    }
+    else if (gpio == GPIOC)
+    {
+        __HAL_RCC_GPIOC_CLK_ENABLE();
+    }
+    else
+    {
+        __HAL_RCC_GPIOD_CLK_ENABLE();
+    }
+}
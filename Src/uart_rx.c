@@ -0,0 +1,163 @@
+/**
+  ******************************************************************************
+  * @file    Src/uart_rx.c
+  * @brief   Circular DMA reception, one ring per UART port.
+  *
+  *          Each port's RX DMA stream runs in circular mode over its row of
+  *          rx_buf and never has to be re-armed. The HAL reports the
+  *          current write position on half-transfer, transfer-complete and
+  *          USART IDLE-line events through HAL_UARTEx_RxEventCallback(); each
+  *          event hands the bytes written since the previous event to
+  *          UART_RX_DataCallback(), split in two when the DMA wrapped around.
+  *
+  *          The interrupt only queues the write position; the bytes are
+  *          delivered from PendSV. Each run picks up from where the last one
+  *          stopped, so an event dropped on a full queue is covered by the
+  *          next one.
+  *
+  *          The interrupt also time stamps the event with Timebase_Now().
+  *          The stamp rides in the deferred item's argument next to the port
+  *          and position, truncated to its low RX_STAMP_BITS bits, and is
+  *          rebuilt in full at delivery; PendSV runs long before those
+  *          bits wrap. Every span is delivered with the time its last byte
+  *          was reported, so the application can measure the delay from
+  *          the line to its handler.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_rx.h"
+#include "defer.h"
+#include "timebase.h"
+#include "mem_sections.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Deferred item argument: port (the F407 has six UARTs), write position,
+   then the low bits of the event time stamp (2^19 us, 524 ms of range) */
+#define RX_PORT_BITS    4U
+#define RX_POS_BITS     9U
+#define RX_POS_SHIFT    RX_PORT_BITS
+#define RX_STAMP_SHIFT  (RX_PORT_BITS + RX_POS_BITS)
+#define RX_STAMP_BITS   (32U - RX_STAMP_SHIFT)
+#define RX_FIELD(bits)  ((1UL << (bits)) - 1UL)
+
+#if UART_RX_BUFSIZE >= (1 << 9)
+#error "UART_RX_BUFSIZE too large for the RX event argument"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+DMA_BUFFER static uint8_t rx_buf[UART_PORT_COUNT][UART_RX_BUFSIZE];
+CCMRAM static uint16_t rx_pos[UART_PORT_COUNT];
+static uint32_t rx_restarts[UART_PORT_COUNT];
+
+/* Private function prototypes -----------------------------------------------*/
+static void UART_RX_Deliver(uint32_t arg);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Start circular reception into the port's RX ring, also after a
+  *         deliberate re-initialisation such as a rate change
+  * @param  port: UART port, its hdmarx must be configured in DMA_CIRCULAR mode
+  * @retval HAL status
+  */
+HAL_StatusTypeDef UART_RX_Start(UART_PortTypeDef port)
+{
+    rx_pos[port] = 0;
+
+    return HAL_UARTEx_ReceiveToIdle_DMA(UART_Port_Handle(port), rx_buf[port], UART_RX_BUFSIZE);
+}
+
+/**
+  * @brief  Restart reception after the HAL stopped it on an error, counted
+  *         in UART_RX_GetRestarts()
+  * @param  port: UART port
+  * @retval HAL status
+  */
+HAL_StatusTypeDef UART_RX_Restart(UART_PortTypeDef port)
+{
+    rx_restarts[port]++;
+    return UART_RX_Start(port);
+}
+
+/**
+  * @brief  Queue delivery of the bytes written by the DMA since the previous
+  *         event
+  * @param  port: UART port
+  * @param  pos: DMA write position reported by HAL_UARTEx_RxEventCallback,
+  *              i.e. UART_RX_BUFSIZE minus the stream's NDTR
+  * @retval None
+  */
+RAMFUNC void UART_RX_EventISR(UART_PortTypeDef port, uint16_t pos)
+{
+    Defer_Post(UART_RX_Deliver, (Timebase_Now() << RX_STAMP_SHIFT) |
+                                ((uint32_t)pos << RX_POS_SHIFT) | (uint32_t)port);
+}
+
+/**
+  * @brief  Deliver the bytes up to a DMA write position, runs from PendSV
+  * @param  arg: port, write position and event time, see RX_PORT_BITS
+  * @retval None
+  */
+static void UART_RX_Deliver(uint32_t arg)
+{
+    UART_PortTypeDef port = (UART_PortTypeDef)(arg & RX_FIELD(RX_PORT_BITS));
+    uint16_t pos = (uint16_t)((arg >> RX_POS_SHIFT) & RX_FIELD(RX_POS_BITS));
+    const uint8_t *buf = rx_buf[port];
+    uint16_t last = rx_pos[port];
+    uint32_t now;
+    uint32_t t_us;
+
+    if (pos == last)
+    {
+        return;
+    }
+
+    /* The event happened less than 2^RX_STAMP_BITS us ago */
+    now = Timebase_Now();
+    t_us = now - ((now - (arg >> RX_STAMP_SHIFT)) & RX_FIELD(RX_STAMP_BITS));
+
+    if (pos > last)
+    {
+        /* Linear span */
+        UART_RX_DataCallback(port, &buf[last], pos - last, t_us);
+    }
+    else
+    {
+        /* DMA wrapped: tail of the ring first, then the head */
+        UART_RX_DataCallback(port, &buf[last], UART_RX_BUFSIZE - last, t_us);
+        if (pos > 0)
+        {
+            UART_RX_DataCallback(port, &buf[0], pos, t_us);
+        }
+    }
+
+    rx_pos[port] = (pos == UART_RX_BUFSIZE) ? 0 : pos;
+}
+
+/**
+  * @brief  Number of times reception of a port was restarted after an error
+  * @param  port: UART port
+  * @retval Restart count
+  */
+uint32_t UART_RX_GetRestarts(UART_PortTypeDef port)
+{
+    return rx_restarts[port];
+}
+
+/**
+  * @brief  Received data callback, overridden by the application
+  * @param  port: UART port the bytes arrived on
+  * @param  data: first received byte
+  * @param  len: number of bytes
+  * @param  t_us: Timebase_Now() when the reception event was raised
+  * @retval None
+  */
+__weak void UART_RX_DataCallback(UART_PortTypeDef port, const uint8_t *data, uint16_t len,
+                                 uint32_t t_us)
+{
+    UNUSED(port);
+    UNUSED(data);
+    UNUSED(len);
+    UNUSED(t_us);
+}
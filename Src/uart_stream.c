@@ -0,0 +1,229 @@
+/**
+  ******************************************************************************
+  * @file    Src/uart_stream.c
+  * @brief   Continuous transmission on one UART port using the DMA
+  *          double-buffer mode.
+  *
+  *          While streaming, the port's TX DMA stream runs with DBM set and alternates
+  *          between two equally sized buffers without software re-arming.
+  *          Each time one buffer has been fully read the DMA switches to the
+  *          other and UART_Stream_ReleasedCallback() lets the producer refill
+  *          the released one. A buffer that was not submitted again before the
+  *          DMA comes back to it is sent as-is and counted as an underrun.
+  *
+  *          The stream owns the TX DMA while running: it claims the port
+  *          from the TX queue, so UART_TX_Send() and friends return HAL_BUSY
+  *          at once, and keeps the UART in the BUSY_TX state so direct
+  *          HAL_UART_Transmit_DMA() calls are refused too, until
+  *          UART_Stream_Stop().
+  *
+  *          No command starts a stream; it is an API for applications that
+  *          produce a continuous flow of their own.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_stream.h"
+#include "uart_tx.h"
+
+/* Private variables ---------------------------------------------------------*/
+static UART_HandleTypeDef *stream_huart;
+static UART_PortTypeDef stream_port;
+static volatile bool stream_running = false;
+static volatile bool stream_filled[2];
+static uint32_t stream_underruns = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static void Stream_M0CpltCallback(DMA_HandleTypeDef *hdma);
+static void Stream_M1CpltCallback(DMA_HandleTypeDef *hdma);
+static void Stream_ErrorCallback(DMA_HandleTypeDef *hdma);
+static void Stream_Released(uint8_t idx);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Switch a port's TX DMA stream to double-buffer mode and start
+  *         streaming. Only one port streams at a time.
+  * @param  port: UART port
+  * @param  buf0: first buffer, must already hold data
+  * @param  buf1: second buffer, must already hold data
+  * @param  len: size of each buffer in bytes
+  * @retval HAL_BUSY if a queued transfer is still in flight or a stream is
+  *         already running
+  */
+HAL_StatusTypeDef UART_Stream_Start(UART_PortTypeDef port,
+                                    uint8_t *buf0, uint8_t *buf1, uint16_t len)
+{
+    UART_HandleTypeDef *huart = UART_Port_Handle(port);
+    DMA_HandleTypeDef *hdma = huart->hdmatx;
+
+    if (stream_running || huart->gState != HAL_UART_STATE_READY ||
+        UART_TX_Claim(port) != HAL_OK)
+    {
+        return HAL_BUSY;
+    }
+
+    stream_huart = huart;
+    stream_port = port;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+
+    /* DBM implies circular operation */
+    hdma->Init.Mode = DMA_CIRCULAR;
+#if UART_TX_DMA_FIFO
+    /* Word bursts need both buffers 16-byte aligned and whole bursts,
+       otherwise stream byte by byte */
+    if ((((uint32_t)buf0 | (uint32_t)buf1 | len) & 15U) != 0)
+    {
+        hdma->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        hdma->Init.MemBurst = DMA_MBURST_SINGLE;
+    }
+#endif
+    if (HAL_DMA_Init(hdma) != HAL_OK)
+    {
+        huart->gState = HAL_UART_STATE_READY;
+        UART_TX_Release(port);
+        return HAL_ERROR;
+    }
+
+    hdma->XferCpltCallback = Stream_M0CpltCallback;
+    hdma->XferM1CpltCallback = Stream_M1CpltCallback;
+    hdma->XferHalfCpltCallback = NULL;
+    hdma->XferM1HalfCpltCallback = NULL;
+    hdma->XferErrorCallback = Stream_ErrorCallback;
+
+    stream_filled[0] = false;   /* already being sent */
+    stream_filled[1] = true;
+    stream_running = true;
+
+    if (HAL_DMAEx_MultiBufferStart_IT(hdma, (uint32_t)buf0, (uint32_t)&huart->Instance->DR,
+                                      (uint32_t)buf1, len) != HAL_OK)
+    {
+        UART_Stream_Stop();
+        return HAL_ERROR;
+    }
+
+    /* Let the USART issue DMA requests */
+    __HAL_UART_CLEAR_FLAG(huart, UART_FLAG_TC);
+    SET_BIT(huart->Instance->CR3, USART_CR3_DMAT);
+
+    return HAL_OK;
+}
+
+/**
+  * @brief  Stop streaming and give the TX DMA back to the normal TX path
+  * @param  None
+  * @retval HAL status, HAL_ERROR if no stream is running
+  */
+HAL_StatusTypeDef UART_Stream_Stop(void)
+{
+    UART_HandleTypeDef *huart = stream_huart;
+    DMA_HandleTypeDef *hdma;
+    HAL_StatusTypeDef status;
+
+    /* Once stopped the DMA belongs to the queue again, leave it alone */
+    if (!stream_running || huart == NULL)
+    {
+        return HAL_ERROR;
+    }
+    hdma = huart->hdmatx;
+
+    stream_running = false;
+    stream_huart = NULL;
+    CLEAR_BIT(huart->Instance->CR3, USART_CR3_DMAT);
+    HAL_DMA_Abort(hdma);
+
+    hdma->Init.Mode = DMA_NORMAL;
+#if UART_TX_DMA_FIFO
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdma->Init.MemBurst = DMA_MBURST_INC4;
+#endif
+    status = HAL_DMA_Init(hdma);
+
+    /* The fast TX path keeps DMAT set permanently */
+    if (UART_TX_IsFastPath(stream_port))
+    {
+        SET_BIT(huart->Instance->CR3, USART_CR3_DMAT);
+    }
+
+    huart->gState = HAL_UART_STATE_READY;
+    UART_TX_Release(stream_port);
+    return status;
+}
+
+/**
+  * @brief  Hand a refilled buffer back to the stream
+  * @param  idx: buffer index (0 or 1)
+  * @retval None
+  */
+void UART_Stream_Submit(uint8_t idx)
+{
+    stream_filled[idx & 1U] = true;
+}
+
+/**
+  * @brief  Report whether the stream owns a port's TX DMA
+  * @param  port: UART port
+  * @retval true while that port is streaming
+  */
+bool UART_Stream_IsRunning(UART_PortTypeDef port)
+{
+    return stream_running && stream_port == port;
+}
+
+/**
+  * @brief  Number of times the DMA switched to a buffer that was not refilled
+  * @param  None
+  * @retval Underrun count
+  */
+uint32_t UART_Stream_GetUnderruns(void)
+{
+    return stream_underruns;
+}
+
+/**
+  * @brief  Buffer released callback, overridden by the application
+  * @param  idx: released buffer index
+  * @retval None
+  */
+__weak void UART_Stream_ReleasedCallback(uint8_t idx)
+{
+    UNUSED(idx);
+}
+
+static void Stream_M0CpltCallback(DMA_HandleTypeDef *hdma)
+{
+    UNUSED(hdma);
+    Stream_Released(0);
+}
+
+static void Stream_M1CpltCallback(DMA_HandleTypeDef *hdma)
+{
+    UNUSED(hdma);
+    Stream_Released(1);
+}
+
+static void Stream_ErrorCallback(DMA_HandleTypeDef *hdma)
+{
+    UNUSED(hdma);
+    UART_Stream_Stop();
+}
+
+/**
+  * @brief  Account for the buffer the DMA has just switched to and release
+  *         the one it left
+  * @param  idx: buffer that has been fully read
+  * @retval None
+  */
+static void Stream_Released(uint8_t idx)
+{
+    uint8_t next = idx ^ 1U;
+
+    if (!stream_filled[next])
+    {
+        stream_underruns++;
+    }
+    stream_filled[next] = false;
+    stream_filled[idx] = false;
+
+    UART_Stream_ReleasedCallback(idx);
+}
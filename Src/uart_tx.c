@@ -0,0 +1,734 @@
+/**
+  ******************************************************************************
+  * @file    Src/uart_tx.c
+  * @brief   Queued DMA transmission, one queue per UART port.
+  *
+  *          Pending transfers are kept as (pointer, length) spans in a
+  *          single-producer/single-consumer ring per port. The producer is whichever
+  *          context calls UART_TX_Send() (thread mode or one interrupt
+  *          priority level); the consumer is the TX complete interrupt, which
+  *          retires the span in flight and immediately starts the next one so
+  *          the line does not go idle between messages.
+  *
+  *          The span in flight stays in the ring until it completes, so the
+  *          caller must keep the data unchanged until then. A span that
+  *          starts at a block of the TX buffer pool (uart_pool.c) gives the
+  *          block back when it retires. A span whose DMA transfer fails
+  *          is dropped, counted in the error statistics, and the queue
+  *          moves on to the next one.
+  *
+  *          Each port has one ring per priority class. UART_TX_SendUrgent()
+  *          queues on the urgent ring, everything else is bulk. A bulk span
+  *          goes out in transfers of at most UART_TX_BULK_CHUNK bytes and
+  *          every completion starts the highest-priority data pending, so an
+  *          urgent span waits for at most one bulk chunk, whatever the length
+  *          of the bulk message; the interrupted bulk span resumes where it
+  *          stopped. All classes of a port share one producer context.
+  *
+  *          UART_TX_SendIov() queues a gathered message as consecutive spans
+  *          published together, so a header, a payload living in flash and a
+  *          trailer go out back-to-back without being copied into one buffer.
+  *
+  *          With UART_TX_FASTPATH the HAL transmit state machine is bypassed:
+  *          the stream's CR/FCR values are computed once from the DMA handle,
+  *          USART DMAT stays set, and starting a span is four register writes.
+  *          Completion is taken from the DMA TC interrupt alone, so the next
+  *          span is started while the USART still shifts out the last bytes
+  *          of the previous one; UART_TX_IsIdle() therefore means "DMA idle"
+  *          and callers that reconfigure the USART must also wait for TC.
+  *          The fast path is the default when built in; UART_TX_SetFastPath()
+  *          switches an idle port between it and the HAL path at run time,
+  *          so both can be measured on the same firmware.
+  *
+  *          With UART_TX_DMA_FIFO the stream runs with its FIFO enabled and
+  *          reads memory in 4-beat word bursts (16 bytes per AHB burst instead
+  *          of one transaction per byte). Bursts need a 16-byte aligned
+  *          address and a whole number of bursts, so long spans are sent as
+  *          an unaligned byte-wide head, a burst-wide body and a byte-wide
+  *          tail; each part is a separate DMA transfer chained from the
+  *          completion interrupt. Short spans stay byte-wide.
+  *
+  *          Every span is time stamped with Timebase_Now() when it is
+  *          queued; the completion interrupt stamps each DMA completion and
+  *          adds the time from queueing to the last byte of a span to the
+  *          latency statistics.
+  *
+  *          All state of a port sits in one TX_PortStateTypeDef, so the hot
+  *          paths address it from one base pointer whatever the port count.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart_tx.h"
+#include "uart_pool.h"
+#include "timebase.h"
+#include "mem_sections.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t len;
+    uint32_t queued_us;         /* Timebase_Now() when queued */
+} TX_SpanTypeDef;
+
+/* DMA interrupt status/clear registers as laid out from the stream's
+   StreamBaseAddress (LISR/LIFCR or HISR/HIFCR) */
+typedef struct
+{
+    __IO uint32_t ISR;
+    __IO uint32_t Reserved0;
+    __IO uint32_t IFCR;
+} TX_DMA_BaseTypeDef;
+
+typedef struct
+{
+    TX_SpanTypeDef queue[UART_TX_QUEUE_LEN];
+    volatile uint32_t head;     /* written by the producer only */
+    volatile uint32_t tail;     /* written by the consumer only */
+    uint16_t offset;            /* bytes of the span at tail already sent */
+} TX_RingTypeDef;
+
+typedef struct
+{
+    UART_HandleTypeDef *huart;
+    TX_RingTypeDef ring[UART_TX_CLASS_COUNT];
+    volatile bool active;
+    volatile bool claimed;      /* TX DMA lent out by UART_TX_Claim() */
+    uint8_t seg_class;          /* ring of the DMA transfer in flight */
+    uint16_t seg_len;           /* bytes in the DMA transfer in flight */
+    UART_TX_StatsTypeDef stats;
+#if UART_TX_FASTPATH
+    bool fast;                  /* registers driven directly, not the HAL */
+    DMA_Stream_TypeDef *stream;
+    TX_DMA_BaseTypeDef *dma_base;
+    uint32_t dma_shift;
+    uint32_t dma_cr;
+    uint32_t dma_fcr;
+#endif
+} TX_PortStateTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define TX_QUEUE_MASK (UART_TX_QUEUE_LEN - 1)
+
+/* TCIF, HTIF, TEIF, DMEIF and FEIF of stream 0, shifted by StreamIndex */
+#define TX_DMA_FLAGS_ALL    0x3DU
+#define TX_DMA_FLAG_TC      0x20U
+#define TX_DMA_FLAG_TE      0x08U
+
+/* Word-wide 4-beat memory burst, and the shortest span worth splitting */
+#define TX_DMA_BURST_BYTES  16U
+#define TX_DMA_WIDE_MIN     64U
+#define TX_DMA_WIDE_BITS    (DMA_MDATAALIGN_WORD | DMA_MBURST_INC4)
+
+/* Ring counters run freely from here, only their low bits index the queue;
+   tools/tx_stress.c starts them just below 2^32 to cover the wrap */
+#ifndef UART_TX_INDEX_START
+#define UART_TX_INDEX_START 0U
+#endif
+
+#if (UART_TX_QUEUE_LEN & TX_QUEUE_MASK) != 0
+#error "UART_TX_QUEUE_LEN must be a power of two"
+#endif
+
+#if (UART_TX_BULK_CHUNK < TX_DMA_BURST_BYTES) || ((UART_TX_BULK_CHUNK % TX_DMA_BURST_BYTES) != 0)
+#error "UART_TX_BULK_CHUNK must be a multiple of 16"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+CCMRAM static TX_PortStateTypeDef tx_port[UART_PORT_COUNT];
+
+/* Private function prototypes -----------------------------------------------*/
+static HAL_StatusTypeDef TX_Enqueue(TX_PortStateTypeDef *tx, UART_TX_ClassTypeDef cls,
+                                    const UART_TX_IovTypeDef *iov, uint8_t count);
+static void TX_StartNext(TX_PortStateTypeDef *tx);
+static void TX_DropFailed(UART_PortTypeDef port);
+static HAL_StatusTypeDef TX_StartSegment(TX_PortStateTypeDef *tx, UART_TX_ClassTypeDef cls);
+static HAL_StatusTypeDef TX_StartDMA(TX_PortStateTypeDef *tx, const uint8_t *data,
+                                     uint16_t len, uint32_t width);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Attach the queue to a port initialised by UART_Port_Init()
+  * @param  port: UART port
+  * @retval None
+  */
+void UART_TX_Init(UART_PortTypeDef port)
+{
+    TX_PortStateTypeDef *tx = &tx_port[port];
+    UART_HandleTypeDef *huart = UART_Port_Handle(port);
+
+    tx->huart = huart;
+    for (uint32_t c = 0; c < UART_TX_CLASS_COUNT; c++)
+    {
+        tx->ring[c].head = UART_TX_INDEX_START;
+        tx->ring[c].tail = UART_TX_INDEX_START;
+        tx->ring[c].offset = 0;
+    }
+    tx->active = false;
+    tx->claimed = false;
+
+#if UART_TX_FASTPATH
+    {
+        DMA_HandleTypeDef *hdma = huart->hdmatx;
+
+        /* Normal mode, byte peripheral, settings as given to HAL_DMA_Init() */
+        tx->stream = hdma->Instance;
+        tx->dma_base = (TX_DMA_BaseTypeDef *)hdma->StreamBaseAddress;
+        tx->dma_shift = hdma->StreamIndex;
+        tx->dma_cr = hdma->Init.Channel | hdma->Init.Direction |
+                     hdma->Init.PeriphInc | hdma->Init.MemInc |
+                     hdma->Init.PeriphDataAlignment |
+                     hdma->Init.Priority | DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+        tx->dma_fcr = 0;
+        if (hdma->Init.FIFOMode == DMA_FIFOMODE_ENABLE)
+        {
+            tx->dma_fcr = DMA_SxFCR_DMDIS | hdma->Init.FIFOThreshold;
+        }
+
+        /* The USART keeps requesting DMA for as long as the fast path runs */
+        tx->fast = true;
+        SET_BIT(huart->Instance->CR3, USART_CR3_DMAT);
+    }
+#endif
+}
+
+/**
+  * @brief  Queue a span for transmission, starting the DMA if the line is idle
+  * @param  port: UART port
+  * @param  data: bytes to send, must stay valid until the span completes
+  * @param  len: number of bytes
+  * @retval HAL_OK if queued, HAL_BUSY if the queue is full or the port is
+  *         streaming, HAL_ERROR if data is in CCM RAM
+  */
+RAMFUNC HAL_StatusTypeDef UART_TX_Send(UART_PortTypeDef port, const uint8_t *data, uint16_t len)
+{
+    UART_TX_IovTypeDef iov;
+
+    iov.data = data;
+    iov.len = len;
+    return UART_TX_SendIov(port, &iov, 1);
+}
+
+/**
+  * @brief  Queue a list of fragments to be sent back-to-back, in order
+  * @param  port: UART port
+  * @param  iov: fragments, each must stay valid until it completes. The array
+  *              itself is not referenced after the call.
+  * @param  count: number of fragments
+  * @retval HAL_OK if all fragments were queued, HAL_BUSY if they do not all
+  *         fit or the port is streaming, HAL_ERROR if a fragment lies in CCM RAM, which the DMA cannot
+  *         read (nothing is queued in either case)
+  */
+RAMFUNC HAL_StatusTypeDef UART_TX_SendIov(UART_PortTypeDef port,
+                                          const UART_TX_IovTypeDef *iov, uint8_t count)
+{
+    return TX_Enqueue(&tx_port[port], UART_TX_BULK, iov, count);
+}
+
+/**
+  * @brief  Queue a span ahead of all bulk data; it starts as soon as the bulk
+  *         chunk in flight, if any, is out
+  * @param  port: UART port
+  * @param  data: bytes to send, must stay valid until the span completes
+  * @param  len: number of bytes
+  * @retval HAL_OK if queued, HAL_BUSY if the urgent queue is full or the port
+  *         is streaming, HAL_ERROR if data is in CCM RAM
+  */
+RAMFUNC HAL_StatusTypeDef UART_TX_SendUrgent(UART_PortTypeDef port, const uint8_t *data, uint16_t len)
+{
+    UART_TX_IovTypeDef iov;
+
+    iov.data = data;
+    iov.len = len;
+    return TX_Enqueue(&tx_port[port], UART_TX_URGENT, &iov, 1);
+}
+
+/**
+  * @brief  Retire the span in flight and chain the next one. Called from
+  *         HAL_UART_TxCpltCallback(), or from UART_TX_DMA_IRQHandler() on
+  *         the fast path.
+  * @param  port: UART port
+  * @retval None
+  */
+RAMFUNC void UART_TX_CompleteISR(UART_PortTypeDef port)
+{
+    TX_PortStateTypeDef *tx = &tx_port[port];
+    TX_RingTypeDef *ring = &tx->ring[tx->seg_class];
+    uint32_t tail = ring->tail;
+    uint32_t now = Timebase_Now();
+    const uint8_t *done = NULL;
+
+    tx->stats.done_us = now;
+
+    /* A span sent in several transfers (bulk chunks, FIFO mode splits)
+       stays at tail until its last byte is out */
+    ring->offset += tx->seg_len;
+    if (ring->offset >= ring->queue[tail & TX_QUEUE_MASK].len)
+    {
+        /* Read the span before the slot is handed back to the producer */
+        uint32_t latency = now - ring->queue[tail & TX_QUEUE_MASK].queued_us;
+
+        done = ring->queue[tail & TX_QUEUE_MASK].data;
+        tx->stats.lat_sum_us += latency;
+        if (latency > tx->stats.lat_max_us)
+        {
+            tx->stats.lat_max_us = latency;
+        }
+        ring->offset = 0;
+        tail++;
+        ring->tail = tail;
+        tx->stats.completed++;
+    }
+
+    /* Urgent data first; an interrupted bulk span resumes at its offset */
+    TX_StartNext(tx);
+    if (done != NULL)
+    {
+        UART_Pool_Free(done);
+        UART_TX_CompleteCallback(port);
+    }
+}
+
+/**
+  * @brief  Drop the span whose DMA transfer failed and chain the next one.
+  *         Called from HAL_UART_ErrorCallback(), which also reports receiver
+  *         errors; only a TX transfer ended by a DMA error is acted on. The
+  *         fast path handles its errors in UART_TX_DMA_IRQHandler().
+  * @param  port: UART port
+  * @retval None
+  */
+RAMFUNC void UART_TX_ErrorISR(UART_PortTypeDef port)
+{
+    TX_PortStateTypeDef *tx = &tx_port[port];
+    DMA_HandleTypeDef *hdma = tx->huart->hdmatx;
+
+#if UART_TX_FASTPATH
+    if (tx->fast)
+    {
+        return;
+    }
+#endif
+
+    /* UART_DMAError() ends the transfer and puts gState back to READY; the
+       stream's error code stays set until the next HAL_DMA_Start_IT() */
+    if (!tx->active || hdma->ErrorCode == HAL_DMA_ERROR_NONE ||
+        tx->huart->gState != HAL_UART_STATE_READY)
+    {
+        return;
+    }
+
+    /* A FIFO error does not stop the stream by itself */
+    (void)HAL_DMA_Abort(hdma);
+    hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+
+    TX_DropFailed(port);
+}
+
+/**
+  * @brief  TX DMA stream interrupt on the fast path, replaces
+  *         HAL_DMA_IRQHandler() while the queue owns the stream
+  * @param  port: UART port
+  * @retval None
+  */
+RAMFUNC void UART_TX_DMA_IRQHandler(UART_PortTypeDef port)
+{
+#if UART_TX_FASTPATH
+    TX_PortStateTypeDef *tx = &tx_port[port];
+    uint32_t flags = (tx->dma_base->ISR >> tx->dma_shift) & TX_DMA_FLAGS_ALL;
+
+    tx->dma_base->IFCR = flags << tx->dma_shift;
+
+    /* TE disables the stream; the rest of the span is not sent */
+    if (flags & TX_DMA_FLAG_TE)
+    {
+        TX_DropFailed(port);
+    }
+    else if (flags & TX_DMA_FLAG_TC)
+    {
+        UART_TX_CompleteISR(port);
+    }
+#else
+    UNUSED(port);
+#endif
+}
+
+/**
+  * @brief  Report whether the queue is empty and no DMA is in flight
+  * @param  port: UART port
+  * @retval true when idle
+  */
+bool UART_TX_IsIdle(UART_PortTypeDef port)
+{
+    return !tx_port[port].active;
+}
+
+/**
+  * @brief  Switch an idle port between the register-level fast path and the
+  *         HAL path. Call from the producer context.
+  * @param  port: UART port
+  * @param  enable: true for the fast path
+  * @retval HAL_OK, HAL_BUSY if the port is not idle, HAL_ERROR if the fast
+  *         path is not built in (UART_TX_FASTPATH)
+  */
+HAL_StatusTypeDef UART_TX_SetFastPath(UART_PortTypeDef port, bool enable)
+{
+    TX_PortStateTypeDef *tx = &tx_port[port];
+
+    if (tx->active || tx->claimed)
+    {
+        return HAL_BUSY;
+    }
+#if UART_TX_FASTPATH
+    /* HAL_UART_Transmit_DMA() sets DMAT itself and clears it at TC */
+    tx->fast = enable;
+    if (enable)
+    {
+        SET_BIT(tx->huart->Instance->CR3, USART_CR3_DMAT);
+    }
+    else
+    {
+        CLEAR_BIT(tx->huart->Instance->CR3, USART_CR3_DMAT);
+    }
+    return HAL_OK;
+#else
+    return enable ? HAL_ERROR : HAL_OK;
+#endif
+}
+
+/**
+  * @brief  Report whether a port runs on the fast path
+  * @param  port: UART port
+  * @retval true on the fast path
+  */
+bool UART_TX_IsFastPath(UART_PortTypeDef port)
+{
+#if UART_TX_FASTPATH
+    return tx_port[port].fast;
+#else
+    UNUSED(port);
+    return false;
+#endif
+}
+
+/**
+  * @brief  Take a port's TX DMA away from the queue, for UART_Stream_Start().
+  *         Sends are refused with HAL_BUSY until UART_TX_Release().
+  * @param  port: UART port
+  * @retval HAL_OK if claimed, HAL_BUSY if a span is still queued or in flight
+  */
+HAL_StatusTypeDef UART_TX_Claim(UART_PortTypeDef port)
+{
+    TX_PortStateTypeDef *tx = &tx_port[port];
+
+    /* A send that slips in before the flag is seen leaves the queue busy */
+    tx->claimed = true;
+    __DMB();
+    if (tx->active)
+    {
+        tx->claimed = false;
+        return HAL_BUSY;
+    }
+    return HAL_OK;
+}
+
+/**
+  * @brief  Give a port's TX DMA back to the queue
+  * @param  port: UART port
+  * @retval None
+  */
+void UART_TX_Release(UART_PortTypeDef port)
+{
+    tx_port[port].claimed = false;
+}
+
+/**
+  * @brief  Bulk spans queued on a port since UART_TX_Init(). A span is out
+  *         of the queue, sent or dropped on a DMA error, once
+  *         UART_TX_Retired() reaches the value read right after queueing it.
+  * @param  port: UART port
+  * @retval Span count, wraps at 2^32
+  */
+uint32_t UART_TX_Queued(UART_PortTypeDef port)
+{
+    return tx_port[port].ring[UART_TX_BULK].head;
+}
+
+/**
+  * @brief  Bulk spans that left the queue of a port since UART_TX_Init()
+  * @param  port: UART port
+  * @retval Span count, wraps at 2^32
+  */
+uint32_t UART_TX_Retired(UART_PortTypeDef port)
+{
+    return tx_port[port].ring[UART_TX_BULK].tail;
+}
+
+/**
+  * @brief  Spans queued on one class of a port since UART_TX_Init(), the
+  *         counterpart of UART_TX_Queued() for urgent spans
+  * @param  port: UART port
+  * @param  cls: priority class
+  * @retval Span count, wraps at 2^32
+  */
+uint32_t UART_TX_ClassQueued(UART_PortTypeDef port, UART_TX_ClassTypeDef cls)
+{
+    return tx_port[port].ring[cls].head;
+}
+
+/**
+  * @brief  Spans that left one class queue of a port since UART_TX_Init()
+  * @param  port: UART port
+  * @param  cls: priority class
+  * @retval Span count, wraps at 2^32
+  */
+uint32_t UART_TX_ClassRetired(UART_PortTypeDef port, UART_TX_ClassTypeDef cls)
+{
+    return tx_port[port].ring[cls].tail;
+}
+
+/**
+  * @brief  Copy the queue statistics
+  * @param  port: UART port
+  * @param  stats: destination
+  * @retval None
+  */
+void UART_TX_GetStats(UART_PortTypeDef port, UART_TX_StatsTypeDef *stats)
+{
+    *stats = tx_port[port].stats;
+}
+
+/**
+  * @brief  Queue fragments on one class ring, starting the DMA if idle
+  * @param  tx: port state
+  * @param  cls: priority class
+  * @param  iov: fragments
+  * @param  count: number of fragments
+  * @retval See UART_TX_SendIov()
+  */
+RAMFUNC static HAL_StatusTypeDef TX_Enqueue(TX_PortStateTypeDef *tx, UART_TX_ClassTypeDef cls,
+                                            const UART_TX_IovTypeDef *iov, uint8_t count)
+{
+    TX_RingTypeDef *ring = &tx->ring[cls];
+    uint32_t head = ring->head;
+    uint32_t depth = head - ring->tail;
+    uint32_t now = Timebase_Now();
+    uint32_t used = 0;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (iov[i].len > 0)
+        {
+            if (!MEM_IS_DMA_SAFE(iov[i].data))
+            {
+                return HAL_ERROR;
+            }
+            used++;
+        }
+    }
+    if (used == 0)
+    {
+        return HAL_OK;
+    }
+    if (depth + used > UART_TX_QUEUE_LEN || tx->claimed)
+    {
+        tx->stats.rejected++;
+        return HAL_BUSY;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (iov[i].len > 0)
+        {
+            ring->queue[head & TX_QUEUE_MASK].data = iov[i].data;
+            ring->queue[head & TX_QUEUE_MASK].len = iov[i].len;
+            ring->queue[head & TX_QUEUE_MASK].queued_us = now;
+            head++;
+        }
+    }
+
+    /* Publish all fragments at once */
+    __DMB();
+    ring->head = head;
+
+    tx->stats.queued += used;
+    if (cls == UART_TX_URGENT)
+    {
+        tx->stats.urgent += used;
+    }
+    if (depth + used > tx->stats.max_depth)
+    {
+        tx->stats.max_depth = depth + used;
+    }
+
+    /* With nothing in flight no completion can preempt us here, and a
+       completion that ran before this point already saw the new head */
+    if (!tx->active)
+    {
+        tx->active = true;
+        TX_StartNext(tx);
+    }
+
+    return HAL_OK;
+}
+
+/**
+  * @brief  Start the DMA on the highest-priority span pending, skipping spans
+  *         that fail to start
+  * @param  tx: port state
+  * @retval None
+  */
+RAMFUNC static void TX_StartNext(TX_PortStateTypeDef *tx)
+{
+    const uint8_t *done;
+
+    for (uint32_t c = UART_TX_CLASS_COUNT; c-- > 0U; )
+    {
+        TX_RingTypeDef *ring = &tx->ring[c];
+        uint32_t tail = ring->tail;
+
+        while (tail != ring->head)
+        {
+            if (TX_StartSegment(tx, (UART_TX_ClassTypeDef)c) == HAL_OK)
+            {
+                if (c != UART_TX_BULK && tx->ring[UART_TX_BULK].offset != 0U)
+                {
+                    tx->stats.preempted++;
+                }
+                return;
+            }
+
+            done = ring->queue[tail & TX_QUEUE_MASK].data;
+            tx->stats.errors++;
+            ring->offset = 0;
+            tail++;
+            ring->tail = tail;
+            UART_Pool_Free(done);
+        }
+    }
+
+    tx->active = false;
+}
+
+/**
+  * @brief  Drop the whole span whose DMA transfer failed, not counted as
+  *         completed, and chain the next one
+  * @param  port: UART port
+  * @retval None
+  */
+RAMFUNC static void TX_DropFailed(UART_PortTypeDef port)
+{
+    TX_PortStateTypeDef *tx = &tx_port[port];
+    TX_RingTypeDef *ring = &tx->ring[tx->seg_class];
+    uint32_t tail = ring->tail;
+    const uint8_t *done = ring->queue[tail & TX_QUEUE_MASK].data;
+
+    tx->stats.errors++;
+    ring->offset = 0;
+    tail++;
+    ring->tail = tail;
+
+    TX_StartNext(tx);
+    UART_Pool_Free(done);
+    UART_TX_CompleteCallback(port);
+}
+
+/**
+  * @brief  Start the next DMA transfer of the span at the tail of a ring, from
+  *         the ring's offset on
+  * @param  tx: port state
+  * @param  cls: ring to take the span from
+  * @retval HAL status
+  */
+RAMFUNC static HAL_StatusTypeDef TX_StartSegment(TX_PortStateTypeDef *tx, UART_TX_ClassTypeDef cls)
+{
+    TX_RingTypeDef *ring = &tx->ring[cls];
+    const TX_SpanTypeDef *span = &ring->queue[ring->tail & TX_QUEUE_MASK];
+    const uint8_t *p = span->data + ring->offset;
+    uint16_t left = span->len - ring->offset;
+    uint32_t width = 0;
+
+#if UART_TX_DMA_FIFO
+    if (left >= TX_DMA_WIDE_MIN || ring->offset != 0)
+    {
+        uint32_t misalign = (uint32_t)p & (TX_DMA_BURST_BYTES - 1U);
+
+        if (misalign != 0)
+        {
+            /* Byte-wide head up to the next burst boundary */
+            if (left > TX_DMA_BURST_BYTES - misalign)
+            {
+                left = (uint16_t)(TX_DMA_BURST_BYTES - misalign);
+            }
+        }
+        else if (left >= TX_DMA_BURST_BYTES)
+        {
+            /* Whole bursts; the byte-wide tail follows as its own transfer */
+            left &= (uint16_t)~(TX_DMA_BURST_BYTES - 1U);
+            width = TX_DMA_WIDE_BITS;
+        }
+    }
+#endif
+
+    /* Bound the time an urgent span can wait behind bulk data. The chunk
+       is a whole number of bursts, so a wide transfer stays wide. */
+    if (cls == UART_TX_BULK && left > UART_TX_BULK_CHUNK)
+    {
+        left = UART_TX_BULK_CHUNK;
+    }
+
+    tx->seg_class = (uint8_t)cls;
+    tx->seg_len = left;
+    return TX_StartDMA(tx, p, left, width);
+}
+
+/**
+  * @brief  Point the TX DMA at one transfer and start it
+  * @param  tx: port state
+  * @param  data: first byte
+  * @param  len: number of bytes
+  * @param  width: memory size and burst bits, 0 for single bytes
+  * @retval HAL status
+  */
+RAMFUNC static HAL_StatusTypeDef TX_StartDMA(TX_PortStateTypeDef *tx, const uint8_t *data,
+                                             uint16_t len, uint32_t width)
+{
+#if UART_TX_FASTPATH
+    if (tx->fast)
+    {
+        DMA_Stream_TypeDef *stream = tx->stream;
+
+        /* The stream disables itself at TC, nothing to wait for */
+        if (stream->CR & DMA_SxCR_EN)
+        {
+            return HAL_BUSY;
+        }
+        tx->dma_base->IFCR = TX_DMA_FLAGS_ALL << tx->dma_shift;
+        stream->PAR = (uint32_t)&tx->huart->Instance->DR;
+        stream->M0AR = (uint32_t)data;
+        stream->NDTR = len;
+        stream->FCR = tx->dma_fcr;
+        stream->CR = tx->dma_cr | width;
+        stream->CR = tx->dma_cr | width | DMA_SxCR_EN;
+        return HAL_OK;
+    }
+#endif
+#if UART_TX_DMA_FIFO
+    /* HAL_DMA_Start_IT() leaves MSIZE/MBURST as they are in CR */
+    MODIFY_REG(tx->huart->hdmatx->Instance->CR, DMA_SxCR_MSIZE | DMA_SxCR_MBURST, width);
+#else
+    UNUSED(width);
+#endif
+    return HAL_UART_Transmit_DMA(tx->huart, (uint8_t *)data, len);
+}
+
+/**
+  * @brief  Span completion callback, overridden by the application
+  * @param  port: UART port
+  * @retval None
+  */
+__weak void UART_TX_CompleteCallback(UART_PortTypeDef port)
+{
+    UNUSED(port);
+}
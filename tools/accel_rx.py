@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Decode the accelerometer telemetry frames of Src/accel.c.
+
+Each frame is a packet (COBS + STM32 CRC32, see Inc/packet.h) carrying
+
+    0x03 | varint index | varint period_us | count | sample...
+
+where every sample is three zigzag varints, x y z, each the difference to
+the previous sample of the frame (the first is relative to zero). Samples
+are written as CSV lines "t_s,x_mg,y_mg,z_mg"; other text on the link goes
+to stderr, and a summary with lost samples and the compression against raw
+6-byte samples is printed at the end.
+
+    tools/accel_rx.py /dev/rfcomm0 --baud 115200 > accel.csv
+    tools/accel_rx.py capture.bin
+
+Only the Python standard library is needed.
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from tlog_decode import open_input, split_chunk, varint  # noqa: E402
+
+ACCEL_FRAME_TYPE = 0x03
+MG_PER_COUNT = 0.06         # LIS3DSH at +-2 g
+
+
+def zigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def decode_frame(payload):
+    """Return (index, period_us, [(x, y, z), ...]) of one frame payload."""
+    index, pos = varint(payload, 1)
+    period_us, pos = varint(payload, pos)
+    count = payload[pos]
+    pos += 1
+    samples = []
+    prev = [0, 0, 0]
+    for _ in range(count):
+        for axis in range(3):
+            delta, pos = varint(payload, pos)
+            prev[axis] += zigzag(delta)
+        samples.append(tuple(prev))
+    if pos != len(payload):
+        raise ValueError('trailing bytes')
+    return index, period_us, samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('input', nargs='?', default='-',
+                        help='serial device or capture file, - for stdin')
+    parser.add_argument('--baud', type=int, default=9600, help='serial rate (default 9600)')
+    parser.add_argument('--raw', action='store_true', help='print sensor counts instead of mg')
+    opts = parser.parse_args()
+
+    fd = sys.stdin.fileno() if opts.input == '-' else open_input(opts.input, opts.baud)
+    out, err = sys.stdout, sys.stderr
+    scale = 1 if opts.raw else MG_PER_COUNT
+    pending = bytearray()
+    frames = samples = lost = bad = wire = 0
+    next_index = None
+
+    try:
+        while True:
+            data = os.read(fd, 4096)
+            if not data:
+                break
+            pending += data
+            while True:
+                end = pending.find(b'\0')
+                if end < 0:
+                    break
+                chunk = bytes(pending[:end])
+                del pending[:end + 1]
+                # printf text ahead of a frame shares its delimiter
+                text, payload = split_chunk(chunk, ACCEL_FRAME_TYPE)
+                err.write(text.decode('latin-1'))
+                if payload is None:
+                    continue
+                try:
+                    index, period_us, batch = decode_frame(payload)
+                except (ValueError, IndexError):
+                    bad += 1
+                    continue
+
+                # The index restarts at 0 with every run
+                if next_index is not None and index > next_index:
+                    lost += index - next_index
+                next_index = index + len(batch)
+                frames += 1
+                samples += len(batch)
+                wire += len(chunk) - len(text) + 1
+                for i, (x, y, z) in enumerate(batch):
+                    t = (index + i) * period_us / 1e6
+                    out.write('%.6f,%g,%g,%g\n' % (t, x * scale, y * scale, z * scale))
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+
+    if samples:
+        err.write('\nframes %d samples %d lost %d bad frames %d, %.2f bytes/sample '
+                  'on the wire (raw 6), %.1fx\n'
+                  % (frames, samples, lost, bad, wire / samples, 6.0 * samples / wire))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Receive the pattern frame stream of BENCH_StreamStart() and check it.
+
+Every frame is a packet (COBS + STM32 CRC32, see Inc/packet.h) carrying
+
+    0x02 | seq u32 LE | t_us u32 LE | pattern, byte i = (seq + i) & 0xFF
+
+The receiver counts lost, repeated and corrupted frames and reports goodput
+and the spread of the end-to-end latency. The two clocks are not
+synchronised, so latency is given relative to the fastest frame of the run:
+it shows queueing and jitter on top of the fixed link delay.
+
+    tools/bench_rx.py /dev/rfcomm0 --baud 115200
+    tools/bench_rx.py --selftest --baud 115200 --drop 500 --corrupt 700
+
+--selftest runs a stand-in for the firmware on a pseudo-terminal pair, with
+optional frame loss and corruption, to check the receiver itself.
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import threading
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from tlog_decode import crc32_stm32, open_input, packet_payload  # noqa: E402
+
+BENCH_FRAME_TYPE = 0x02
+BENCH_FRAME_HEADER = 9
+
+
+class Receiver:
+    def __init__(self):
+        self.frames = 0
+        self.lost = 0
+        self.repeated = 0
+        self.bad_pattern = 0
+        self.bad_frames = 0
+        self.payload_bytes = 0
+        self.wire_bytes = 0
+        self.next_seq = None
+        self.first_ns = None
+        self.last_ns = None
+        self.offsets = []
+        self.dev_high = 0
+        self.dev_last = None
+
+    def device_us(self, t):
+        # Unwrap the 32-bit device time
+        if self.dev_last is not None and t < self.dev_last and self.dev_last - t > 1 << 31:
+            self.dev_high += 1 << 32
+        self.dev_last = t
+        return self.dev_high + t
+
+    def chunk(self, data, now_ns, out):
+        """One delimiter-terminated chunk of the byte stream."""
+        self.wire_bytes += len(data) + 1
+        for start in range(len(data)):
+            payload = packet_payload(data[start:])
+            if payload and payload[0] == BENCH_FRAME_TYPE:
+                if start:
+                    out.write(data[:start].decode('latin-1'))
+                self.frame(payload, now_ns)
+                return
+        if data and all(32 <= b < 127 or b in (9, 10, 13) for b in data):
+            out.write(data.decode('latin-1'))
+        elif data:
+            self.bad_frames += 1
+
+    def frame(self, payload, now_ns):
+        if len(payload) < BENCH_FRAME_HEADER:
+            self.bad_frames += 1
+            return
+        seq, t_us = struct.unpack_from('<II', payload, 1)
+        pattern = payload[BENCH_FRAME_HEADER:]
+        if any(b != (seq + i) & 0xFF for i, b in enumerate(pattern)):
+            self.bad_pattern += 1
+            return
+
+        if self.next_seq is None or seq == 0:
+            self.next_seq = seq
+        if seq < self.next_seq:
+            self.repeated += 1
+            return
+        self.lost += seq - self.next_seq
+        self.next_seq = seq + 1
+
+        self.frames += 1
+        self.payload_bytes += len(pattern)
+        if self.first_ns is None:
+            self.first_ns = now_ns
+        self.last_ns = now_ns
+        self.offsets.append(now_ns / 1000.0 - self.device_us(t_us))
+
+    def report(self, out):
+        if self.frames == 0:
+            out.write('no frames received\n')
+            return
+        secs = max((self.last_ns - self.first_ns) / 1e9, 1e-9)
+        expected = self.frames + self.lost
+        out.write('frames %d lost %d (%.3f%%) repeated %d bad pattern %d bad packets %d\n'
+                  % (self.frames, self.lost, 100.0 * self.lost / expected, self.repeated,
+                     self.bad_pattern, self.bad_frames))
+        out.write('goodput %.0f B/s (%.0f frames/s), wire %.0f B/s over %.2f s\n'
+                  % (self.payload_bytes / secs, self.frames / secs, self.wire_bytes / secs, secs))
+        base = min(self.offsets)
+        lat = sorted(o - base for o in self.offsets)
+
+        def pct(p):
+            return lat[min(len(lat) - 1, int(p / 100.0 * len(lat)))] / 1000.0
+
+        out.write('latency above fastest frame (ms): p50 %.2f p90 %.2f p99 %.2f max %.2f\n'
+                  % (pct(50), pct(90), pct(99), lat[-1] / 1000.0))
+
+
+def cobs_encode(data):
+    out = bytearray()
+    block = bytearray()
+    for b in data:
+        if b == 0:
+            out.append(len(block) + 1)
+            out += block
+            block = bytearray()
+        else:
+            block.append(b)
+    out.append(len(block) + 1)
+    out += block
+    return bytes(out) + b'\0'
+
+
+def stand_in(fd, baud, seconds, payload_len, drop, corrupt):
+    """Firmware stand-in: frames paced at the line rate of baud."""
+    start = time.monotonic()
+    byte_time = 10.0 / baud
+    sent_until = start
+    seq = 0
+    while time.monotonic() - start < seconds:
+        t_us = int((time.monotonic() - start) * 1e6) & 0xFFFFFFFF
+        payload = struct.pack('<BII', BENCH_FRAME_TYPE, seq, t_us)
+        payload += bytes((seq + i) & 0xFF for i in range(payload_len - BENCH_FRAME_HEADER))
+        frame = bytearray(cobs_encode(payload + struct.pack('<I', crc32_stm32(payload))))
+        if corrupt and seq % corrupt == corrupt - 1:
+            frame[len(frame) // 2] ^= 0x40 if frame[len(frame) // 2] != 0x40 else 0x41
+        if not (drop and seq % drop == drop - 1):
+            os.write(fd, bytes(frame))
+            sent_until = max(sent_until, time.monotonic()) + len(frame) * byte_time
+            delay = sent_until - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+        seq += 1
+    os.write(fd, b'\r\nstream stand-in done\r\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('input', nargs='?', help='serial device or capture file')
+    parser.add_argument('--baud', type=int, default=115200, help='serial rate (default 115200)')
+    parser.add_argument('--idle', type=float, default=2.0,
+                        help='seconds without data that end a run (default 2)')
+    parser.add_argument('--selftest', action='store_true', help='receive from a stand-in on a pty')
+    parser.add_argument('--seconds', type=float, default=3.0, help='stand-in run time')
+    parser.add_argument('--payload', type=int, default=64, help='stand-in frame payload')
+    parser.add_argument('--drop', type=int, default=0, help='stand-in drops every Nth frame')
+    parser.add_argument('--corrupt', type=int, default=0, help='stand-in corrupts every Nth frame')
+    opts = parser.parse_args()
+
+    if opts.selftest:
+        master, slave = os.openpty()
+        fd = open_input(os.ttyname(slave), opts.baud)
+        threading.Thread(target=stand_in, daemon=True,
+                         args=(master, opts.baud, opts.seconds, opts.payload,
+                               opts.drop, opts.corrupt)).start()
+    elif opts.input:
+        fd = open_input(opts.input, opts.baud)
+    else:
+        parser.error('give an input or --selftest')
+
+    rx = Receiver()
+    out = sys.stdout
+    pending = bytearray()
+    try:
+        while True:
+            if not select.select([fd], [], [], opts.idle)[0]:
+                if rx.frames:
+                    break
+                continue
+            try:
+                data = os.read(fd, 4096)
+            except OSError:
+                break
+            if not data:
+                break
+            now = time.monotonic_ns()
+            pending += data
+            while True:
+                end = pending.find(b'\0')
+                if end < 0:
+                    break
+                rx.chunk(bytes(pending[:end]), now, out)
+                del pending[:end + 1]
+    except KeyboardInterrupt:
+        pass
+
+    if pending:
+        out.write(pending.decode('latin-1'))
+    out.write('\n')
+    rx.report(out)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,162 @@
+/**
+  ******************************************************************************
+  * @file    tools/cmd_bench.c
+  * @brief   Host benchmark of the command parser in Src/cmd.c.
+  *
+  *          Replays recorded link input through Cmd_Feed() in spans of a
+  *          fixed size, as the RX ring would hand them over, and reports
+  *          commands per second. Without an input file a mix of typical
+  *          command lines is generated.
+  *
+  *          cc -O2 -IInc tools/cmd_bench.c Src/cmd.c -o cmd_bench
+  *          ./cmd_bench [-s span_bytes] [-n passes] [capture.txt]
+  ******************************************************************************
+  */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "cmd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static unsigned long handled;
+static unsigned long arg_bytes;
+
+/* Handlers only count, the parser and the lookup are what is measured */
+#define BENCH_HANDLER(name) \
+    void name(const char *arg, uint16_t len) { (void)arg; handled++; arg_bytes += len; }
+
+BENCH_HANDLER(Cmd_OnHelp)
+BENCH_HANDLER(Cmd_OnMsg)
+BENCH_HANDLER(Cmd_OnBaud)
+BENCH_HANDLER(Cmd_OnStats)
+BENCH_HANDLER(Cmd_OnEvents)
+BENCH_HANDLER(Cmd_OnProf)
+BENCH_HANDLER(Cmd_OnSweep)
+BENCH_HANDLER(Cmd_OnBench)
+BENCH_HANDLER(Cmd_OnStream)
+BENCH_HANDLER(Cmd_OnAccel)
+BENCH_HANDLER(Cmd_OnTxCost)
+
+static const char *const sample_lines[] =
+{
+    "msg Hello from STM32 via HC-05\r\n",
+    "baud 115200\r\n",
+    "stats\r\n",
+    "E\n",
+    "help\r\n",
+    "sweep\r\n",
+    "msg sensor 42 ok\n",
+    "bogus command\r\n",
+    "events\r\n",
+    "?\r\n",
+};
+
+static unsigned char *load(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    unsigned char *buf;
+    long size;
+
+    if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) <= 0)
+    {
+        perror(path);
+        exit(1);
+    }
+    rewind(f);
+    buf = malloc((size_t)size);
+    if (buf == NULL || fread(buf, 1, (size_t)size, f) != (size_t)size)
+    {
+        perror(path);
+        exit(1);
+    }
+    fclose(f);
+    *len = (size_t)size;
+    return buf;
+}
+
+static unsigned char *generate(size_t *len)
+{
+    size_t cap = 64 * 1024;
+    unsigned char *buf = malloc(cap);
+    size_t n = 0;
+
+    for (unsigned i = 0; buf != NULL; i++)
+    {
+        const char *line = sample_lines[i % (sizeof(sample_lines) / sizeof(sample_lines[0]))];
+        size_t l = strlen(line);
+
+        if (n + l > cap)
+        {
+            break;
+        }
+        memcpy(&buf[n], line, l);
+        n += l;
+    }
+    *len = n;
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    Cmd_ParserTypeDef parser;
+    unsigned char *input;
+    size_t len;
+    size_t span = 64;
+    unsigned long passes = 2000;
+    struct timespec t0, t1;
+    double secs;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            span = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            passes = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s span_bytes] [-n passes] [capture]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (span == 0 || span > 0xFFFF)
+    {
+        fprintf(stderr, "span must be 1..65535\n");
+        return 2;
+    }
+
+    input = (optind < argc) ? load(argv[optind], &len) : generate(&len);
+    Cmd_Init(&parser);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned long p = 0; p < passes; p++)
+    {
+        for (size_t off = 0; off < len; off += span)
+        {
+            size_t n = (len - off < span) ? len - off : span;
+
+            Cmd_Feed(&parser, &input[off], (uint16_t)n);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    printf("%zu bytes x %lu passes in %zu-byte spans: %.3f s\n", len, passes, span, secs);
+    printf("lines %lu  commands %lu  unknown %lu  carried %lu  overflow %lu\n",
+           (unsigned long)parser.stats.lines, handled,
+           (unsigned long)parser.stats.unknown, (unsigned long)parser.stats.carried,
+           (unsigned long)parser.stats.overflow);
+    printf("%.0f commands/s, %.1f ns/command, %.1f MB/s\n",
+           (double)handled / secs, secs * 1e9 / (double)(handled ? handled : 1),
+           (double)len * (double)passes / secs / 1e6);
+
+    free(input);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Search the perfect hash used by the command table in Src/cmd.c.
+
+    slot = (name[0] * A + name[len - 1] * B + len) & (SIZE - 1)
+
+Prints the smallest SIZE, A and B that give every command its own slot and
+the matching initializers for cmd_table[]. Rerun after adding a command and
+paste the output into Src/cmd.c and the CMD_HASH_* constants into Inc/cmd.h.
+"""
+
+import sys
+
+# name -> handler, in the order they are listed in Src/cmd.c
+COMMANDS = [
+    ('help', 'Cmd_OnHelp'),
+    ('msg', 'Cmd_OnMsg'),
+    ('baud', 'Cmd_OnBaud'),
+    ('stats', 'Cmd_OnStats'),
+    ('events', 'Cmd_OnEvents'),
+    ('prof', 'Cmd_OnProf'),
+    ('sweep', 'Cmd_OnSweep'),
+    ('bench', 'Cmd_OnBench'),
+    ('stream', 'Cmd_OnStream'),
+    ('accel', 'Cmd_OnAccel'),
+    ('txcost', 'Cmd_OnTxCost'),
+    # single-character commands of earlier firmware
+    ('?', 'Cmd_OnProf'),
+    ('B', 'Cmd_OnSweep'),
+    ('C', 'Cmd_OnBench'),
+    ('E', 'Cmd_OnEvents'),
+]
+
+
+def slot(name, a, b, size):
+    return (ord(name[0]) * a + ord(name[-1]) * b + len(name)) & (size - 1)
+
+
+def search():
+    size = 1
+    while size < len(COMMANDS):
+        size *= 2
+    while size <= 256:
+        for a in range(1, 64):
+            for b in range(0, 64):
+                slots = [slot(n, a, b, size) for n, _ in COMMANDS]
+                if len(set(slots)) == len(slots):
+                    return size, a, b
+        size *= 2
+    sys.exit('no perfect hash found')
+
+
+def main():
+    size, a, b = search()
+    print('#define CMD_HASH_SIZE %d' % size)
+    print('#define CMD_HASH_A    %dU' % a)
+    print('#define CMD_HASH_B    %dU' % b)
+    print()
+    rows = sorted((slot(n, a, b, size), n, h) for n, h in COMMANDS)
+    width = max(len(n) for n, _ in COMMANDS) + 3
+    for s, name, handler in rows:
+        quoted = ('"%s",' % name).ljust(width)
+        print('    [%2d] = { %s %d, %s },' % (s, quoted, len(name), handler))
+
+
+if __name__ == '__main__':
+    main()
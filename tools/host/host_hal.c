@@ -0,0 +1,518 @@
+/**
+  ******************************************************************************
+  * @file    tools/host/host_hal.c
+  * @brief   Simulated UART/DMA links, PendSV and TIM2 for host builds.
+  *
+  *          Stands in for uart_port.c and the HAL underneath the TX queue,
+  *          the RX ring, the deferred-work queue and the packet code, so
+  *          those modules run unchanged under gcc. The model follows what
+  *          the firmware relies on:
+  *
+  *          - Time is virtual. A TX transfer occupies the line for ten bit
+  *            times per byte at the port's rate; Host_Advance() moves time
+  *            forward and completes transfers in order, calling
+  *            HAL_UART_TxCpltCallback() at the instant the last byte leaves.
+  *            TIM2->CNT follows the clock in microseconds.
+  *          - Reception is a circular DMA: Host_Receive() writes bytes into
+  *            the buffer given to HAL_UARTEx_ReceiveToIdle_DMA() and raises
+  *            HAL_UARTEx_RxEventCallback() at half and full buffer and on an
+  *            IDLE line, with the sizes the F4 HAL reports (no IDLE event when
+  *            the write position is back at the start of the buffer).
+  *          - Every simulated interrupt is followed by PendSV if it was
+  *            pended, unless Host_HoldPendSV() keeps it back to model a
+  *            long-running higher-priority handler.
+  *          - HAL_CRC_* compute the STM32 CRC32 in software.
+  *
+  *          The application's HAL callbacks (as in main.c) are supplied by
+  *          the host program; the defaults here do nothing.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "host_hal.h"
+#include "defer.h"
+#include <string.h>
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+    const uint8_t *tx_data;     /* transfer in flight, NULL when idle */
+    uint16_t tx_len;
+    uint64_t tx_end_ns;         /* time its last byte leaves the line */
+    uint64_t tx_bytes;
+    uint64_t tx_busy_ns;
+    Host_SinkTypeDef sink;
+    uint16_t rx_pos;            /* DMA write position, size - NDTR */
+} Host_PortTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+UART_HandleTypeDef uart_port_huart[UART_PORT_COUNT];
+DMA_HandleTypeDef uart_port_hdmatx[UART_PORT_COUNT];
+DMA_HandleTypeDef uart_port_hdmarx[UART_PORT_COUNT];
+
+SCB_Type host_scb;
+TIM_TypeDef host_tim2;
+CRC_TypeDef host_crc;
+
+static USART_TypeDef host_usart[UART_PORT_COUNT];
+static DMA_Stream_TypeDef host_stream_tx[UART_PORT_COUNT];
+static DMA_Stream_TypeDef host_stream_rx[UART_PORT_COUNT];
+static Host_PortTypeDef host_port[UART_PORT_COUNT];
+static uint64_t host_now_ns;
+static bool host_pendsv_hold;
+
+/* Private function prototypes -----------------------------------------------*/
+static void Host_SetTime(uint64_t ns);
+static void Host_Interrupt(void);
+static uint64_t Host_ByteNs(UART_PortTypeDef port);
+static void Host_RxEvent(UART_PortTypeDef port, uint16_t size);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Reset every link, idle, at 9600 baud with the clock at start_us
+  * @param  start_us: initial TIM2 count, e.g. close to a wrap
+  * @retval None
+  */
+void Host_Init(uint32_t start_us)
+{
+    memset(host_port, 0, sizeof(host_port));
+    host_scb.ICSR = 0;
+    host_pendsv_hold = false;
+    Host_SetTime((uint64_t)start_us * 1000U);
+
+    for (uint32_t i = 0; i < UART_PORT_COUNT; i++)
+    {
+        UART_HandleTypeDef *huart = &uart_port_huart[i];
+
+        memset(huart, 0, sizeof(*huart));
+        memset(&uart_port_hdmatx[i], 0, sizeof(uart_port_hdmatx[i]));
+        memset(&uart_port_hdmarx[i], 0, sizeof(uart_port_hdmarx[i]));
+        uart_port_hdmatx[i].Instance = &host_stream_tx[i];
+        uart_port_hdmatx[i].State = HAL_DMA_STATE_READY;
+        uart_port_hdmarx[i].Instance = &host_stream_rx[i];
+        uart_port_hdmarx[i].State = HAL_DMA_STATE_READY;
+        huart->Instance = &host_usart[i];
+        huart->Init.BaudRate = 9600;
+        huart->hdmatx = &uart_port_hdmatx[i];
+        huart->hdmarx = &uart_port_hdmarx[i];
+        huart->gState = HAL_UART_STATE_READY;
+        huart->RxState = HAL_UART_STATE_READY;
+    }
+}
+
+/**
+  * @brief  Line rate of a port, used for transfers started from now on
+  * @param  port: UART port
+  * @param  baud: bits per second
+  * @retval None
+  */
+void Host_SetBaudRate(UART_PortTypeDef port, uint32_t baud)
+{
+    uart_port_huart[port].Init.BaudRate = baud;
+}
+
+/**
+  * @brief  Hand the bytes of every completed TX transfer to a function, e.g.
+  *         to loop them back into a receiver
+  * @param  port: UART port
+  * @param  sink: called at completion, NULL to discard the bytes
+  * @retval None
+  */
+void Host_SetTxSink(UART_PortTypeDef port, Host_SinkTypeDef sink)
+{
+    host_port[port].sink = sink;
+}
+
+/**
+  * @brief  Keep PendSV from running after interrupts, or release it
+  * @param  hold: true to hold PendSV back; false runs it at once if pended
+  * @retval None
+  */
+void Host_HoldPendSV(bool hold)
+{
+    host_pendsv_hold = hold;
+    if (!hold)
+    {
+        Host_PendSV();
+    }
+}
+
+/**
+  * @brief  Run the deferred-work queue if PendSV is pended
+  * @param  None
+  * @retval None
+  */
+void Host_PendSV(void)
+{
+    while ((host_scb.ICSR & SCB_ICSR_PENDSVSET_Msk) != 0U)
+    {
+        host_scb.ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+        Defer_IRQHandler();
+    }
+}
+
+/**
+  * @brief  Current simulated time
+  * @param  None
+  * @retval Nanoseconds, not wrapping
+  */
+uint64_t Host_NowNs(void)
+{
+    return host_now_ns;
+}
+
+/**
+  * @brief  Let time pass, completing every TX transfer that ends meanwhile
+  *         in the order they end
+  * @param  us: microseconds to advance
+  * @retval None
+  */
+void Host_Advance(uint32_t us)
+{
+    uint64_t target = host_now_ns + (uint64_t)us * 1000U;
+
+    for (;;)
+    {
+        int32_t next = -1;
+
+        for (uint32_t i = 0; i < UART_PORT_COUNT; i++)
+        {
+            if (host_port[i].tx_data != NULL && host_port[i].tx_end_ns <= target &&
+                (next < 0 || host_port[i].tx_end_ns < host_port[next].tx_end_ns))
+            {
+                next = (int32_t)i;
+            }
+        }
+        if (next < 0)
+        {
+            break;
+        }
+        Host_TxComplete((UART_PortTypeDef)next);
+    }
+    Host_SetTime(target);
+}
+
+/**
+  * @brief  Report whether a TX transfer is on the line
+  * @param  port: UART port
+  * @retval true while a transfer is in flight
+  */
+bool Host_TxBusy(UART_PortTypeDef port)
+{
+    return host_port[port].tx_data != NULL;
+}
+
+/**
+  * @brief  Complete the TX transfer in flight now, moving the clock to its
+  *         end if that is later, and run the completion interrupt
+  * @param  port: UART port
+  * @retval Bytes completed, 0 if the line was idle
+  */
+uint16_t Host_TxComplete(UART_PortTypeDef port)
+{
+    Host_PortTypeDef *hp = &host_port[port];
+    UART_HandleTypeDef *huart = &uart_port_huart[port];
+    const uint8_t *data = hp->tx_data;
+    uint16_t len = hp->tx_len;
+
+    if (data == NULL)
+    {
+        return 0;
+    }
+    if (hp->tx_end_ns > host_now_ns)
+    {
+        Host_SetTime(hp->tx_end_ns);
+    }
+
+    hp->tx_data = NULL;
+    hp->tx_bytes += len;
+    huart->hdmatx->State = HAL_DMA_STATE_READY;
+    huart->gState = HAL_UART_STATE_READY;
+    if (hp->sink != NULL)
+    {
+        hp->sink(port, data, len);
+    }
+
+    HAL_UART_TxCpltCallback(huart);
+    Host_Interrupt();
+    return len;
+}
+
+/**
+  * @brief  Fail the TX transfer in flight the way a DMA transfer error does
+  *         on the HAL path: the stream stops, the HAL ends the transmission
+  *         and calls HAL_UART_ErrorCallback()
+  * @param  port: UART port
+  * @retval None
+  */
+void Host_TxError(UART_PortTypeDef port)
+{
+    Host_PortTypeDef *hp = &host_port[port];
+    UART_HandleTypeDef *huart = &uart_port_huart[port];
+
+    if (hp->tx_data == NULL)
+    {
+        return;
+    }
+    hp->tx_data = NULL;
+    huart->hdmatx->ErrorCode |= HAL_DMA_ERROR_TE;
+    huart->hdmatx->State = HAL_DMA_STATE_READY;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->ErrorCode |= HAL_UART_ERROR_DMA;
+
+    HAL_UART_ErrorCallback(huart);
+    Host_Interrupt();
+}
+
+/**
+  * @brief  Bytes a port has put on the line
+  * @param  port: UART port
+  * @retval Byte count
+  */
+uint64_t Host_TxBytes(UART_PortTypeDef port)
+{
+    return host_port[port].tx_bytes;
+}
+
+/**
+  * @brief  Time a port's line has been busy sending
+  * @param  port: UART port
+  * @retval Nanoseconds
+  */
+uint64_t Host_TxBusyNs(UART_PortTypeDef port)
+{
+    return host_port[port].tx_busy_ns;
+}
+
+/**
+  * @brief  Receive bytes through the circular RX DMA of a port, raising the
+  *         half and full buffer events as they are crossed
+  * @param  port: UART port, reception started
+  * @param  data: bytes arriving on the line
+  * @param  len: number of bytes
+  * @param  idle: true to end the burst with an IDLE line event
+  * @retval None
+  */
+void Host_Receive(UART_PortTypeDef port, const uint8_t *data, uint32_t len, bool idle)
+{
+    UART_HandleTypeDef *huart = &uart_port_huart[port];
+    Host_PortTypeDef *hp = &host_port[port];
+    uint16_t size = huart->RxXferSize;
+
+    if (huart->RxState != HAL_UART_STATE_BUSY_RX)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        huart->pRxBuffPtr[hp->rx_pos++] = data[i];
+        if (hp->rx_pos == size / 2U)
+        {
+            Host_RxEvent(port, size / 2U);
+        }
+        else if (hp->rx_pos == size)
+        {
+            /* Circular mode: NDTR reloads, the DMA goes on at the start */
+            hp->rx_pos = 0;
+            Host_RxEvent(port, size);
+        }
+    }
+
+    if (idle && hp->rx_pos != 0)
+    {
+        Host_RxEvent(port, hp->rx_pos);
+    }
+}
+
+/**
+  * @brief  DMA write position of a port's receiver
+  * @param  port: UART port
+  * @retval RxXferSize minus NDTR
+  */
+uint16_t Host_RxPos(UART_PortTypeDef port)
+{
+    return host_port[port].rx_pos;
+}
+
+/**
+  * @brief  Set the clock and the TIM2 count that follows it
+  * @param  ns: new time
+  * @retval None
+  */
+static void Host_SetTime(uint64_t ns)
+{
+    host_now_ns = ns;
+    host_tim2.CNT = (uint32_t)(ns / 1000U);
+}
+
+/**
+  * @brief  Return from a simulated interrupt: PendSV runs next
+  * @param  None
+  * @retval None
+  */
+static void Host_Interrupt(void)
+{
+    if (!host_pendsv_hold)
+    {
+        Host_PendSV();
+    }
+}
+
+/**
+  * @brief  Line time of one byte, start and stop bit included
+  * @param  port: UART port
+  * @retval Nanoseconds
+  */
+static uint64_t Host_ByteNs(UART_PortTypeDef port)
+{
+    return 10000000000ULL / uart_port_huart[port].Init.BaudRate;
+}
+
+/**
+  * @brief  Raise a reception event
+  * @param  port: UART port
+  * @param  size: write position reported to the callback
+  * @retval None
+  */
+static void Host_RxEvent(UART_PortTypeDef port, uint16_t size)
+{
+    HAL_UARTEx_RxEventCallback(&uart_port_huart[port], size);
+    Host_Interrupt();
+}
+
+/* HAL stand-ins -------------------------------------------------------------*/
+
+/**
+  * @brief  Interrupt priorities have no meaning on the host
+  */
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    UNUSED(IRQn);
+    UNUSED(PreemptPriority);
+    UNUSED(SubPriority);
+}
+
+/**
+  * @brief  Start a TX transfer; it completes in Host_Advance() or
+  *         Host_TxComplete()
+  * @param  huart: UART handle of the port table
+  * @param  pData: bytes, read when the transfer completes
+  * @param  Size: number of bytes
+  * @retval HAL_BUSY while a transfer is in flight
+  */
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    UART_PortTypeDef port = UART_Port_FromHandle(huart);
+    Host_PortTypeDef *hp = &host_port[port];
+    uint64_t duration;
+
+    if (huart->gState != HAL_UART_STATE_READY || huart->hdmatx->State != HAL_DMA_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0U)
+    {
+        return HAL_ERROR;
+    }
+
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    huart->hdmatx->State = HAL_DMA_STATE_BUSY;
+    huart->hdmatx->ErrorCode = HAL_DMA_ERROR_NONE;
+    duration = Host_ByteNs(port) * Size;
+    hp->tx_data = pData;
+    hp->tx_len = Size;
+    hp->tx_end_ns = host_now_ns + duration;
+    hp->tx_busy_ns += duration;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Start circular reception with IDLE detection
+  * @param  huart: UART handle of the port table
+  * @param  pData: ring buffer
+  * @param  Size: ring size, even
+  * @retval HAL_BUSY if reception is already running
+  */
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    host_port[UART_Port_FromHandle(huart)].rx_pos = 0;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Stop a stream; as in the HAL, fails when nothing is running
+  * @param  hdma: DMA handle
+  * @retval HAL_ERROR if no transfer was in progress
+  */
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma)
+{
+    if (hdma->State != HAL_DMA_STATE_BUSY)
+    {
+        hdma->ErrorCode = HAL_DMA_ERROR_NO_XFER;
+        return HAL_ERROR;
+    }
+    hdma->State = HAL_DMA_STATE_READY;
+    return HAL_OK;
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    UNUSED(huart);
+}
+
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    UNUSED(huart);
+}
+
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    UNUSED(huart);
+    UNUSED(Size);
+}
+
+/**
+  * @brief  Reset the CRC unit
+  */
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc)
+{
+    hcrc->Instance->DR = 0xFFFFFFFFU;
+    return HAL_OK;
+}
+
+/**
+  * @brief  Feed words to the CRC unit: polynomial 0x04C11DB7, MSB first
+  */
+uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength)
+{
+    uint32_t crc = hcrc->Instance->DR;
+
+    for (uint32_t i = 0; i < BufferLength; i++)
+    {
+        crc ^= pBuffer[i];
+        for (uint32_t bit = 0; bit < 32U; bit++)
+        {
+            crc = (crc & 0x80000000U) ? (crc << 1) ^ 0x04C11DB7U : (crc << 1);
+        }
+    }
+    hcrc->Instance->DR = crc;
+    return crc;
+}
+
+/**
+  * @brief  Reset the CRC unit and feed words to it
+  */
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength)
+{
+    hcrc->Instance->DR = 0xFFFFFFFFU;
+    return HAL_CRC_Accumulate(hcrc, pBuffer, BufferLength);
+}
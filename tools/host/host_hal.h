@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file    tools/host/host_hal.h
+  * @brief   Header for host_hal.c - simulated UART/DMA links and time base
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __HOST_HAL_H
+#define __HOST_HAL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx_hal.h"
+#include "uart_port.h"
+#include <stdbool.h>
+
+/* Exported types ------------------------------------------------------------*/
+/* Receives the bytes of every TX transfer of a port when it completes */
+typedef void (*Host_SinkTypeDef)(UART_PortTypeDef port, const uint8_t *data, uint16_t len);
+
+/* Exported functions ------------------------------------------------------- */
+void Host_Init(uint32_t start_us);
+void Host_SetBaudRate(UART_PortTypeDef port, uint32_t baud);
+void Host_SetTxSink(UART_PortTypeDef port, Host_SinkTypeDef sink);
+void Host_HoldPendSV(bool hold);
+void Host_PendSV(void);
+
+uint64_t Host_NowNs(void);
+void Host_Advance(uint32_t us);
+bool Host_TxBusy(UART_PortTypeDef port);
+uint16_t Host_TxComplete(UART_PortTypeDef port);
+void Host_TxError(UART_PortTypeDef port);
+uint64_t Host_TxBytes(UART_PortTypeDef port);
+uint64_t Host_TxBusyNs(UART_PortTypeDef port);
+
+void Host_Receive(UART_PortTypeDef port, const uint8_t *data, uint32_t len, bool idle);
+uint16_t Host_RxPos(UART_PortTypeDef port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HOST_HAL_H */
@@ -0,0 +1,187 @@
+/**
+  ******************************************************************************
+  * @file    tools/host/stm32f4xx_hal.h
+  * @brief   Host stand-in for the parts of the STM32F4 HAL and CMSIS used by
+  *          the UART modules, so they build and run under gcc on Linux.
+  *
+  *          Put tools/host before Inc on the include path; this header then
+  *          replaces the real HAL for uart_tx.c, uart_rx.c, uart_pool.c,
+  *          defer.c and packet.c. Peripherals are plain structs in host
+  *          memory and the functions are simulated by host_hal.c. Only the
+  *          default build options are covered: no UART_TX_FASTPATH, no
+  *          UART_TX_DMA_FIFO.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/* Exported macro ------------------------------------------------------------*/
+#define __IO                volatile
+#define __weak              __attribute__((weak))
+#define __STATIC_INLINE     static inline
+#define UNUSED(x)           ((void)(x))
+
+#define SET_BIT(REG, BIT)       ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)     ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)      ((REG) & (BIT))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) \
+    ((REG) = (((REG) & (~(CLEARMASK))) | (SETMASK)))
+
+/* Core intrinsics: the host runs one context at a time, so exclusive
+   stores always succeed */
+#define __DMB()             __sync_synchronize()
+#define __CLREX()           do { } while (0)
+#define __LDREXW(p)         (*(p))
+#define __STREXW(v, p)      ((*(p) = (v)), 0U)
+#define __CLZ(x)            ((x) == 0U ? 32U : (uint32_t)__builtin_clz(x))
+#define __disable_irq()     do { } while (0)
+#define __enable_irq()      do { } while (0)
+
+__STATIC_INLINE uint32_t __RBIT(uint32_t x)
+{
+    uint32_t r = 0;
+
+    for (uint32_t i = 0; i < 32U; i++)
+    {
+        r = (r << 1) | ((x >> i) & 1U);
+    }
+    return r;
+}
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+    HAL_OK       = 0x00U,
+    HAL_ERROR    = 0x01U,
+    HAL_BUSY     = 0x02U,
+    HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    PendSV_IRQn = -2
+} IRQn_Type;
+
+typedef struct
+{
+    __IO uint32_t ICSR;
+} SCB_Type;
+
+typedef struct
+{
+    __IO uint32_t SR;
+    __IO uint32_t DR;
+    __IO uint32_t BRR;
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t CR3;
+    __IO uint32_t GTPR;
+} USART_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR;
+    __IO uint32_t NDTR;
+    __IO uint32_t PAR;
+    __IO uint32_t M0AR;
+    __IO uint32_t M1AR;
+    __IO uint32_t FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CNT;
+} TIM_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t DR;
+} CRC_TypeDef;
+
+typedef struct
+{
+    DMA_Stream_TypeDef *Instance;
+    __IO uint32_t State;
+    __IO uint32_t ErrorCode;
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+    uint32_t BaudRate;
+} UART_InitTypeDef;
+
+typedef struct
+{
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+    uint8_t *pRxBuffPtr;
+    uint16_t RxXferSize;
+    __IO uint32_t gState;
+    __IO uint32_t RxState;
+    __IO uint32_t ErrorCode;
+} UART_HandleTypeDef;
+
+typedef struct
+{
+    CRC_TypeDef *Instance;
+} CRC_HandleTypeDef;
+
+/* Exported constants --------------------------------------------------------*/
+#define SCB_ICSR_PENDSVSET_Msk      (1UL << 28)
+
+#define HAL_UART_STATE_READY        0x20U
+#define HAL_UART_STATE_BUSY_TX      0x21U
+#define HAL_UART_STATE_BUSY_RX      0x22U
+
+#define HAL_UART_ERROR_NONE         0x00U
+#define HAL_UART_ERROR_DMA          0x10U
+
+#define HAL_DMA_STATE_READY         0x01U
+#define HAL_DMA_STATE_BUSY          0x02U
+
+#define HAL_DMA_ERROR_NONE          0x00U
+#define HAL_DMA_ERROR_TE            0x01U
+#define HAL_DMA_ERROR_NO_XFER       0x80U
+
+/* Exported variables --------------------------------------------------------*/
+extern SCB_Type host_scb;
+extern TIM_TypeDef host_tim2;
+extern CRC_TypeDef host_crc;
+
+#define SCB     (&host_scb)
+#define TIM2    (&host_tim2)
+#define CRC     (&host_crc)
+
+#define __HAL_RCC_CRC_CLK_ENABLE()  do { } while (0)
+
+/* Exported functions ------------------------------------------------------- */
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *hcrc);
+uint32_t HAL_CRC_Calculate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength);
+uint32_t HAL_CRC_Accumulate(CRC_HandleTypeDef *hcrc, uint32_t pBuffer[], uint32_t BufferLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F4xx_HAL_H */
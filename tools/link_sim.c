@@ -0,0 +1,246 @@
+/**
+  ******************************************************************************
+  * @file    tools/link_sim.c
+  * @brief   Host benchmark of the TX queue, RX ring and packet framing over
+  *          a simulated link (tools/host).
+  *
+  *          The firmware modules run unchanged: frames are encoded with
+  *          Packet_Encode() and queued with UART_TX_Send() as the stream
+  *          benchmark does, the simulated line loops every byte back into
+  *          the port's circular RX DMA, and UART_RX_DataCallback() splits
+  *          and decodes the frames. Reports goodput, line utilisation, TX
+  *          queue latency and the end-to-end latency from queueing a frame
+  *          to its last byte reaching the receive callback, in simulated
+  *          time. Exits non-zero if a frame is lost, repeated or corrupt.
+  *
+  *          cc -O2 -Itools/host -IInc tools/link_sim.c tools/host/host_hal.c \
+  *             Src/uart_tx.c Src/uart_rx.c Src/uart_pool.c Src/defer.c \
+  *             Src/packet.c -o link_sim
+  *          ./link_sim [-b baud] [-n frames] [-p payload] [-k frames_in_flight]
+  ******************************************************************************
+  */
+
+#include "host_hal.h"
+#include "uart_tx.h"
+#include "uart_rx.h"
+#include "uart_pool.h"
+#include "defer.h"
+#include "packet.h"
+#include "timebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PORT            UART_PORT_HC05
+#define FRAMES_MAX      16U
+#define HEADER          8U
+#define STEP_US         10U
+
+static uint32_t frame_buf[FRAMES_MAX][(PACKET_BUFSIZE(PACKET_MAX_PAYLOAD) + 3U) / 4U];
+static uint32_t frame_ticket[FRAMES_MAX];
+
+/* Receiver: one frame collected up to its delimiter */
+static uint32_t rx_frame[(PACKET_BUFSIZE(PACKET_MAX_PAYLOAD) + 3U) / 4U];
+static uint16_t rx_len;
+static bool rx_overflow;
+static uint32_t rx_seq;
+static unsigned long rx_frames, rx_bad, rx_lost, rx_repeat;
+static uint64_t rx_lat_sum;
+static uint32_t rx_lat_max;
+static uint16_t payload_len;
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    UART_TX_CompleteISR(UART_Port_FromHandle(huart));
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    UART_RX_EventISR(UART_Port_FromHandle(huart), Size);
+}
+
+/* Every byte sent comes back on the same port */
+static void loopback(UART_PortTypeDef port, const uint8_t *data, uint16_t len)
+{
+    Host_Receive(port, data, len, false);
+}
+
+static void frame_check(uint8_t *frame, uint16_t len, uint32_t t_us)
+{
+    int32_t n = Packet_Decode(frame, len);
+    uint32_t seq, sent_us, lat;
+
+    if (n != (int32_t)payload_len)
+    {
+        rx_bad++;
+        return;
+    }
+    memcpy(&seq, &frame[0], 4);
+    memcpy(&sent_us, &frame[4], 4);
+    for (uint16_t i = HEADER; i < payload_len; i++)
+    {
+        if (frame[i] != (uint8_t)(seq + i))
+        {
+            rx_bad++;
+            return;
+        }
+    }
+    if (seq < rx_seq)
+    {
+        rx_repeat++;
+        return;
+    }
+    rx_lost += seq - rx_seq;
+    rx_seq = seq + 1U;
+    rx_frames++;
+
+    lat = t_us - sent_us;
+    rx_lat_sum += lat;
+    if (lat > rx_lat_max)
+    {
+        rx_lat_max = lat;
+    }
+}
+
+void UART_RX_DataCallback(UART_PortTypeDef port, const uint8_t *data, uint16_t len,
+                          uint32_t t_us)
+{
+    uint8_t *buf = (uint8_t *)rx_frame;
+
+    (void)port;
+    /* Time the frame at delivery, the event stamp marks its last DMA event */
+    (void)t_us;
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (data[i] == PACKET_DELIMITER)
+        {
+            if (!rx_overflow && rx_len > 0)
+            {
+                frame_check(buf, rx_len, Timebase_Now());
+            }
+            rx_len = 0;
+            rx_overflow = false;
+        }
+        else if (rx_len < sizeof(rx_frame))
+        {
+            buf[rx_len++] = data[i];
+        }
+        else
+        {
+            rx_overflow = true;
+        }
+    }
+}
+
+static void frame_fill(uint8_t *payload, uint32_t seq)
+{
+    uint32_t now = Timebase_Now();
+
+    memcpy(&payload[0], &seq, 4);
+    memcpy(&payload[4], &now, 4);
+    for (uint16_t i = HEADER; i < payload_len; i++)
+    {
+        payload[i] = (uint8_t)(seq + i);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t baud = 115200;
+    uint32_t frames = 10000;
+    uint32_t inflight = 4;
+    uint32_t head = 0, tail = 0;
+    uint8_t *pending = NULL;
+    uint16_t pending_len = 0;
+    uint64_t start_ns, elapsed_ns;
+    UART_TX_StatsTypeDef tx;
+    int opt;
+
+    payload_len = 64;
+    while ((opt = getopt(argc, argv, "b:n:p:k:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b': baud = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'n': frames = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'p': payload_len = (uint16_t)strtoul(optarg, NULL, 0); break;
+        case 'k': inflight = (uint32_t)strtoul(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-b baud] [-n frames] [-p payload] [-k frames_in_flight]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (payload_len < HEADER || payload_len > PACKET_MAX_PAYLOAD ||
+        inflight < 1 || inflight > FRAMES_MAX || baud == 0)
+    {
+        fprintf(stderr, "payload must be %u..%u bytes, frames in flight 1..%u\n",
+                HEADER, PACKET_MAX_PAYLOAD, FRAMES_MAX);
+        return 2;
+    }
+
+    Host_Init(0);
+    Host_SetBaudRate(PORT, baud);
+    Host_SetTxSink(PORT, loopback);
+    Defer_Init();
+    UART_Pool_Init();
+    Packet_Init();
+    UART_TX_Init(PORT);
+    UART_RX_Start(PORT);
+
+    start_ns = Host_NowNs();
+    while (tail < frames || !UART_TX_IsIdle(PORT))
+    {
+        /* Reclaim frames the DMA is done with, keep the queue topped up */
+        while (tail != head &&
+               (int32_t)(UART_TX_Retired(PORT) - frame_ticket[tail % inflight]) >= 0)
+        {
+            tail++;
+        }
+        while (head < frames && head - tail < inflight)
+        {
+            if (pending == NULL)
+            {
+                uint8_t *buf = (uint8_t *)frame_buf[head % inflight];
+
+                frame_fill(PACKET_PAYLOAD(buf), head);
+                pending_len = Packet_Encode(buf, payload_len, &pending);
+            }
+            if (UART_TX_Send(PORT, pending, pending_len) != HAL_OK)
+            {
+                break;
+            }
+            frame_ticket[head % inflight] = UART_TX_Queued(PORT);
+            pending = NULL;
+            head++;
+        }
+
+        Host_Advance(STEP_US);
+        if (!Host_TxBusy(PORT))
+        {
+            /* The line went quiet: IDLE flushes the tail of the ring */
+            Host_Receive(PORT, NULL, 0, true);
+        }
+    }
+    elapsed_ns = Host_NowNs() - start_ns;
+
+    UART_TX_GetStats(PORT, &tx);
+    printf("%lu frames of %u bytes at %lu baud, %u in flight, %.3f s simulated\n",
+           (unsigned long)frames, payload_len, (unsigned long)baud, inflight,
+           (double)elapsed_ns / 1e9);
+    printf("goodput %.0f B/s, line busy %.1f%%, wire %llu bytes\n",
+           (double)rx_frames * payload_len * 1e9 / (double)elapsed_ns,
+           100.0 * (double)Host_TxBusyNs(PORT) / (double)elapsed_ns,
+           (unsigned long long)Host_TxBytes(PORT));
+    printf("tx queue latency avg %llu max %lu us, depth max %u, rejected %lu\n",
+           (unsigned long long)(tx.completed ? tx.lat_sum_us / tx.completed : 0),
+           (unsigned long)tx.lat_max_us, tx.max_depth, (unsigned long)tx.rejected);
+    printf("end-to-end latency avg %llu max %lu us\n",
+           (unsigned long long)(rx_frames ? rx_lat_sum / rx_frames : 0),
+           (unsigned long)rx_lat_max);
+    printf("received %lu lost %lu repeated %lu bad %lu\n",
+           rx_frames, rx_lost + (frames - rx_seq), rx_repeat, rx_bad);
+
+    return (rx_frames == frames && rx_bad == 0 && rx_repeat == 0) ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+/**
+  ******************************************************************************
+  * @file    tools/rx_ring_test.c
+  * @brief   Host test of the circular DMA receive path in Src/uart_rx.c.
+  *
+  *          Drives the RX ring through the simulated DMA of tools/host: the
+  *          write position (RxXferSize - NDTR) moves byte by byte and raises
+  *          the half-transfer, transfer-complete and IDLE events the F4 HAL
+  *          reports. Checks that the spans handed to UART_RX_DataCallback()
+  *          lie inside the ring, follow each other without gap or overlap,
+  *          and add up to exactly the bytes received, across wraparound,
+  *          bursts of exactly one buffer, events that pile up while PendSV
+  *          is held back, and time stamps across the TIM2 wrap.
+  *
+  *          cc -O2 -Itools/host -IInc tools/rx_ring_test.c tools/host/host_hal.c \
+  *             Src/uart_rx.c Src/defer.c -o rx_ring_test && ./rx_ring_test
+  ******************************************************************************
+  */
+
+#include "host_hal.h"
+#include "uart_rx.h"
+#include "defer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PORT        UART_PORT_HC05
+#define SENT_MAX    (1U << 20)
+
+static uint8_t sent[SENT_MAX];
+static uint32_t sent_len;
+static uint8_t got[SENT_MAX];
+static uint32_t got_len;
+static uint32_t ring_next;          /* ring offset the next span must start at */
+static uint64_t total_len;         /* bytes of earlier, already compared rounds */
+static uint32_t spans;
+static uint32_t expect_t_us;        /* event time the next delivery reports */
+static bool check_time;
+static unsigned failures;
+static uint32_t rng = 0x12345678U;
+
+#define CHECK(cond, ...) \
+    do { if (!(cond)) { failures++; printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                        printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    UART_RX_EventISR(UART_Port_FromHandle(huart), Size);
+}
+
+void UART_RX_DataCallback(UART_PortTypeDef port, const uint8_t *data, uint16_t len,
+                          uint32_t t_us)
+{
+    const uint8_t *ring = uart_port_huart[port].pRxBuffPtr;
+    uint32_t offset = (uint32_t)(data - ring);
+
+    spans++;
+    CHECK(len > 0, "empty span");
+    CHECK(data >= ring && offset + len <= UART_RX_BUFSIZE,
+          "span at %ld len %u outside the ring", (long)(data - ring), len);
+    CHECK(offset == ring_next, "span starts at %lu, expected %lu",
+          (unsigned long)offset, (unsigned long)ring_next);
+    CHECK(got_len + len <= sent_len, "more bytes delivered than received");
+    if (check_time)
+    {
+        CHECK(t_us == expect_t_us, "time stamp %lu, expected %lu",
+              (unsigned long)t_us, (unsigned long)expect_t_us);
+    }
+    if (failures > 20)
+    {
+        exit(1);
+    }
+
+    memcpy(&got[got_len], data, len);
+    got_len += len;
+    ring_next = (offset + len) % UART_RX_BUFSIZE;
+}
+
+static uint32_t rand32(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static void receive(uint32_t len, bool idle)
+{
+    uint8_t burst[4 * UART_RX_BUFSIZE];
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        burst[i] = (uint8_t)rand32();
+    }
+    memcpy(&sent[sent_len], burst, len);
+    sent_len += len;
+    Host_Receive(PORT, burst, len, idle);
+}
+
+static void compare(const char *name)
+{
+    CHECK(got_len == sent_len, "%s: %lu bytes delivered of %lu", name,
+          (unsigned long)got_len, (unsigned long)sent_len);
+    CHECK(memcmp(got, sent, got_len < sent_len ? got_len : sent_len) == 0,
+          "%s: delivered bytes differ", name);
+    total_len += sent_len;
+    sent_len = 0;
+    got_len = 0;
+}
+
+/* Compare before the record buffers run out; the line must be flushed */
+static void compare_if_full(const char *name)
+{
+    if (sent_len > SENT_MAX - 4U * UART_RX_BUFSIZE)
+    {
+        compare(name);
+    }
+}
+
+static void check_stream(const char *name)
+{
+    compare(name);
+    printf("%-28s %9llu bytes %8lu spans%s\n", name, (unsigned long long)total_len,
+           (unsigned long)spans, failures ? "" : " ok");
+}
+
+static void reset(uint32_t start_us)
+{
+    Host_Init(start_us);
+    Defer_Init();
+    UART_RX_Start(PORT);
+    sent_len = 0;
+    got_len = 0;
+    total_len = 0;
+    ring_next = 0;
+    spans = 0;
+    check_time = false;
+}
+
+int main(void)
+{
+    /* Each HT, TC and IDLE position delivered on its own */
+    reset(0);
+    receive(UART_RX_BUFSIZE / 2U - 1U, true);       /* IDLE just before HT */
+    receive(1, false);                              /* HT */
+    receive(1, true);                               /* IDLE just after HT */
+    receive(UART_RX_BUFSIZE / 2U - 1U, false);      /* TC, position back to 0 */
+    CHECK(Host_RxPos(PORT) == 0, "write position %u after TC", Host_RxPos(PORT));
+    receive(0, true);                               /* no IDLE event at 0 */
+    receive(3, true);
+    check_stream("HT/TC/IDLE positions");
+
+    /* A burst of exactly one buffer from every start offset */
+    reset(0);
+    for (uint32_t start = 0; start < UART_RX_BUFSIZE; start++)
+    {
+        receive(1, true);
+        receive(UART_RX_BUFSIZE, true);
+    }
+    check_stream("full-buffer bursts");
+
+    /* A whole lap lands before PendSV runs: the write position is back
+       where delivery stopped, the HT/TC events queued on the way cover it */
+    reset(0);
+    for (uint32_t start = 0; start < UART_RX_BUFSIZE; start++)
+    {
+        receive(1, true);
+        Host_HoldPendSV(true);
+        receive(UART_RX_BUFSIZE, (start & 1U) != 0U);
+        Host_HoldPendSV(false);
+        receive(0, true);
+    }
+    check_stream("full lap while held");
+
+    /* Wraparound from every offset, delivered after each event */
+    reset(0);
+    for (uint32_t i = 0; i < 200000U; i++)
+    {
+        receive(1U + rand32() % (2U * UART_RX_BUFSIZE), (rand32() & 3U) != 0U);
+        if (sent_len > SENT_MAX - 4U * UART_RX_BUFSIZE)
+        {
+            receive(0, true);
+            compare("random bursts");
+        }
+    }
+    receive(0, true);
+    check_stream("random bursts");
+
+    /* Events pile up in the deferred queue while PendSV is held back;
+       fine as long as the DMA does not lap the ring meanwhile */
+    reset(0);
+    for (uint32_t i = 0; i < 100000U; i++)
+    {
+        uint32_t left = UART_RX_BUFSIZE - 1U;
+
+        Host_HoldPendSV(true);
+        while (left > 0)
+        {
+            uint32_t n = 1U + rand32() % (left < 40U ? left : 40U);
+
+            receive(n, (rand32() & 1U) != 0U);
+            left -= n;
+        }
+        Host_HoldPendSV(false);
+        receive(0, true);
+        compare_if_full("held PendSV");
+    }
+    check_stream("held PendSV");
+
+    /* Time stamps across the 32-bit wrap, with delivery up to 500 ms late */
+    reset(0xFFFFFFFFU - 2000000U);
+    check_time = true;
+    for (uint32_t i = 0; i < 2000U; i++)
+    {
+        uint32_t delay = rand32() % 500000U;
+
+        expect_t_us = TIM2->CNT;
+        Host_HoldPendSV(true);
+        receive(1U + rand32() % (UART_RX_BUFSIZE / 2U - 1U), true);
+        Host_Advance(delay);
+        Host_HoldPendSV(false);
+    }
+    check_stream("time stamps over TIM2 wrap");
+
+    if (failures)
+    {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}
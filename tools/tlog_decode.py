@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""Decode tokenized log records (Src/tlog.c) from the HC-05 link.
+
+The firmware sends the address of each TLOG() format string instead of the
+text. This tool reads the strings back from the firmware ELF (the .tlog
+section of the GCC build, or wherever the IAR/MDK linker put them), undoes
+the packet framing of Src/packet.c and prints the rebuilt messages. Bytes
+that are not part of a valid log packet, such as printf() output sharing
+the link, are passed through unchanged.
+
+    tools/tlog_decode.py firmware.elf /dev/rfcomm0 --baud 9600
+    tools/tlog_decode.py firmware.elf capture.bin
+
+Only the Python standard library is needed.
+"""
+
+import argparse
+import os
+import re
+import select
+import struct
+import sys
+import termios
+
+TLOG_PACKET_TYPE = 0x01
+
+# C conversion -> (Python conversion, signed)
+_CONVERSIONS = {
+    'd': ('d', True), 'i': ('d', True), 'u': ('d', False),
+    'x': ('x', False), 'X': ('X', False), 'o': ('o', False),
+    'c': ('c', False), 'p': ('x', False),
+}
+_SPEC = re.compile(r'%([-+ #0]*)(\d*|\*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcps%])')
+
+
+class Elf:
+    """Just enough of ELF32/ELF64 to read bytes at a virtual address."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        d = self.data
+        if d[:4] != b'\x7fELF':
+            raise ValueError('%s: not an ELF file' % path)
+        is64 = d[4] == 2
+        end = '<' if d[5] == 1 else '>'
+        if is64:
+            shoff, = struct.unpack_from(end + 'Q', d, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(end + 'HHH', d, 0x3A)
+            fmt = end + 'IIQQQQ'
+        else:
+            shoff, = struct.unpack_from(end + 'I', d, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(end + 'HHH', d, 0x2E)
+            fmt = end + 'IIIIII'
+        raw = []
+        for i in range(shnum):
+            name, stype, _flags, addr, offset, size = struct.unpack_from(fmt, d, shoff + i * shentsize)
+            raw.append((name, stype, addr, offset, size))
+        strtab = raw[shstrndx][3]
+        self.sections = []
+        for name, stype, addr, offset, size in raw:
+            if stype == 8:      # SHT_NOBITS, nothing in the file
+                continue
+            sname = d[strtab + name:d.index(b'\0', strtab + name)].decode()
+            self.sections.append((sname, addr, offset, size))
+
+    def string(self, addr):
+        # The .tlog section first: it starts at address 0 and overlaps others
+        for sname, base, offset, size in sorted(self.sections, key=lambda s: s[0] != '.tlog'):
+            # Debug and attribute sections also sit at 0, only .tlog counts
+            if sname == '.tlog' or base != 0:
+                if base <= addr < base + size:
+                    start = offset + addr - base
+                    stop = self.data.index(b'\0', start)
+                    return self.data[start:stop].decode('latin-1')
+        return None
+
+
+def crc32_stm32(data):
+    """CRC unit of the STM32F4 over little-endian words, last word zero-padded."""
+    crc = 0xFFFFFFFF
+    data = bytes(data) + b'\0' * (-len(data) % 4)
+    for i in range(0, len(data), 4):
+        crc ^= struct.unpack_from('<I', data, i)[0]
+        for _ in range(32):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else (crc << 1)
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def packet_payload(frame):
+    data = cobs_decode(frame)
+    if data is None or len(data) < 4:
+        return None
+    payload, crc = data[:-4], struct.unpack('<I', data[-4:])[0]
+    if crc32_stm32(payload) != crc:
+        return None
+    return payload
+
+
+def varint(buf, pos):
+    value = shift = 0
+    while True:
+        if pos >= len(buf) or shift > 28:
+            raise ValueError('truncated varint')
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if b < 0x80:
+            return value, pos
+
+
+def format_message(fmt, args):
+    args = list(args)
+    out = []
+    pos = 0
+    for m in _SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, _length, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        if width == '*':
+            width = str(args.pop(0)) if args else ''
+        value = args.pop(0) if args else 0
+        if conv == 's':
+            out.append('<str@0x%x>' % value)
+            continue
+        pyconv, signed = _CONVERSIONS[conv]
+        if signed and value & 0x80000000:
+            value -= 1 << 32
+        if conv == 'p':
+            flags += '#'
+        spec = '%' + flags + width + ('.' + prec if prec and pyconv != 'c' else '') + pyconv
+        out.append(spec % value)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def decode_records(elf, payload):
+    base, pos = varint(payload, 1)
+    while pos < len(payload):
+        dt, pos = varint(payload, pos)
+        token, pos = varint(payload, pos)
+        count = payload[pos]
+        pos += 1
+        args = []
+        for _ in range(count):
+            value, pos = varint(payload, pos)
+            args.append(value)
+        fmt = elf.string(token)
+        if fmt is None:
+            text = '<unknown token 0x%x> %s' % (token, ' '.join('0x%x' % a for a in args))
+        else:
+            text = format_message(fmt, args)
+        yield (base + dt) & 0xFFFFFFFF, text
+
+
+def split_chunk(chunk, packet_type=TLOG_PACKET_TYPE):
+    """Find a packet of the given type at the end of a chunk, after any plain text."""
+    for start in range(len(chunk)):
+        payload = packet_payload(chunk[start:])
+        if payload and payload[0] == packet_type:
+            return chunk[:start], payload
+    return chunk, None
+
+
+def open_input(path, baud):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        attrs = termios.tcgetattr(fd)
+        speed = getattr(termios, 'B%d' % baud)
+        attrs[0] = 0                                    # iflag: raw
+        attrs[1] = 0                                    # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0                                    # lflag: no echo, no canon
+        attrs[4] = attrs[5] = speed
+        attrs[6][termios.VMIN] = 1
+        attrs[6][termios.VTIME] = 0
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('elf', help='firmware ELF the records were logged from')
+    parser.add_argument('input', nargs='?', default='-',
+                        help='serial device or capture file, - for stdin')
+    parser.add_argument('--baud', type=int, default=9600, help='serial rate (default 9600)')
+    opts = parser.parse_args()
+
+    elf = Elf(opts.elf)
+    fd = sys.stdin.fileno() if opts.input == '-' else open_input(opts.input, opts.baud)
+    out = sys.stdout
+    pending = bytearray()
+
+    while True:
+        # Text without a packet behind it is printed once the link goes quiet
+        if pending and not select.select([fd], [], [], 0.2)[0]:
+            out.write(pending.decode('latin-1'))
+            out.flush()
+            pending.clear()
+            continue
+        data = os.read(fd, 4096)
+        if not data:
+            break
+        pending += data
+        while True:
+            end = pending.find(b'\0')
+            if end < 0:
+                break
+            chunk = bytes(pending[:end])
+            del pending[:end + 1]
+            text, payload = split_chunk(chunk)
+            if text:
+                out.write(text.decode('latin-1'))
+            if payload is not None:
+                try:
+                    for tick, message in decode_records(elf, payload):
+                        out.write('[%10.3f] %s\n' % (tick / 1000.0, message))
+                except (ValueError, IndexError):
+                    out.write('<malformed log packet>\n')
+            out.flush()
+
+    if pending:
+        out.write(pending.decode('latin-1'))
+
+
+if __name__ == '__main__':
+    main()
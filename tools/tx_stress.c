@@ -0,0 +1,384 @@
+/**
+  ******************************************************************************
+  * @file    tools/tx_stress.c
+  * @brief   Host long-run stress test of the TX span queue in Src/uart_tx.c.
+  *
+  *          Interleaves, at random, UART_TX_Send(), UART_TX_SendIov() and
+  *          UART_TX_SendUrgent() on the producer side with transfer
+  *          completions and the odd DMA error on the consumer side, for
+  *          millions of steps, and checks every transfer the simulated DMA
+  *          is given against a model of the queue:
+  *
+  *          - each class goes out in queue order, byte for byte, with no
+  *            span lost, repeated or sent after it was dropped;
+  *          - a bulk span goes out in chunks of at most UART_TX_BULK_CHUNK
+  *            and urgent data waits behind at most one of them;
+  *          - every span retires exactly once, the bulk tickets of
+  *            UART_TX_Queued()/UART_TX_Retired() match, and the statistics
+  *            add up when the queue drains.
+  *
+  *          The ring counters start just below 2^32 so head and tail wrap
+  *          early in the run.
+  *
+  *          cc -O2 -Itools/host -IInc -DUART_TX_INDEX_START=0xFFFFF000U \
+  *             tools/tx_stress.c tools/host/host_hal.c Src/uart_tx.c \
+  *             Src/uart_pool.c Src/defer.c -o tx_stress
+  *          ./tx_stress [steps]
+  ******************************************************************************
+  */
+
+#include "host_hal.h"
+#include "uart_tx.h"
+#include "uart_pool.h"
+#include "defer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PORT        UART_PORT_HC05
+#define SLOTS       (2U * UART_TX_QUEUE_LEN)
+#define SPAN_MAX    200U
+#define URGENT_MAX  32U
+
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t len;
+    uint16_t sent;              /* bytes already handed to the DMA */
+    uint32_t seq;               /* fill pattern, see pattern() */
+    uint32_t ticket;            /* UART_TX_Queued() right after queueing */
+} Model_SpanTypeDef;
+
+typedef struct
+{
+    uint8_t buf[SLOTS][SPAN_MAX];
+    uint32_t seq;               /* spans filled, varies the pattern */
+    Model_SpanTypeDef span[SLOTS];
+    uint32_t head;              /* model queue, same order as the ring */
+    uint32_t tail;
+} Model_ClassTypeDef;
+
+static Model_ClassTypeDef model[UART_TX_CLASS_COUNT];
+static uint32_t retire_due;     /* spans the sink saw finish, not retired yet */
+static uint32_t bulk_behind;    /* bulk transfers done while urgent data waited */
+static unsigned long long sent_bytes, spans_done, spans_dropped, completions;
+static unsigned failures;
+static uint32_t rng = 0x2545F491U;
+
+#define CHECK(cond, ...) \
+    do { if (!(cond)) { failures++; printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                        printf(__VA_ARGS__); printf("\n"); \
+                        if (failures > 20) exit(1); } } while (0)
+
+static uint32_t rand32(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static uint8_t pattern(UART_TX_ClassTypeDef cls, uint32_t seq, uint32_t i)
+{
+    return (uint8_t)(seq * 7U + i + (uint32_t)cls * 101U);
+}
+
+/* Fill the buffer of the span that will be queued k places after the
+   model's head; slots follow the queue, so one is only reused after its
+   span retired */
+static uint8_t *span_fill(UART_TX_ClassTypeDef cls, uint32_t k, uint16_t len, uint32_t *seq)
+{
+    Model_ClassTypeDef *m = &model[cls];
+    uint8_t *p = m->buf[(m->head + k) % SLOTS];
+
+    *seq = m->seq++;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        p[i] = pattern(cls, *seq, i);
+    }
+    return p;
+}
+
+static void model_push(UART_TX_ClassTypeDef cls, const uint8_t *data, uint16_t len,
+                       uint32_t seq, uint32_t ticket)
+{
+    Model_ClassTypeDef *m = &model[cls];
+    Model_SpanTypeDef *s = &m->span[m->head++ % SLOTS];
+
+    CHECK(m->head - m->tail <= UART_TX_QUEUE_LEN, "model holds more than the queue");
+    s->data = data;
+    s->len = len;
+    s->sent = 0;
+    s->seq = seq;
+    s->ticket = ticket;
+}
+
+static uint32_t model_depth(UART_TX_ClassTypeDef cls)
+{
+    return model[cls].head - model[cls].tail;
+}
+
+static void model_pop(UART_TX_ClassTypeDef cls)
+{
+    Model_ClassTypeDef *m = &model[cls];
+    Model_SpanTypeDef *s = &m->span[m->tail++ % SLOTS];
+
+    if (cls == UART_TX_BULK)
+    {
+        CHECK(UART_TX_Retired(PORT) == s->ticket, "bulk span retired at %lu, ticket %lu",
+              (unsigned long)UART_TX_Retired(PORT), (unsigned long)s->ticket);
+    }
+}
+
+/* Every transfer the DMA completes, in order */
+static void sink(UART_PortTypeDef port, const uint8_t *data, uint16_t len)
+{
+    UART_TX_ClassTypeDef cls = UART_TX_BULK;
+    Model_SpanTypeDef *s;
+
+    (void)port;
+    if (data >= model[UART_TX_URGENT].buf[0] && data < model[UART_TX_URGENT].buf[SLOTS])
+    {
+        cls = UART_TX_URGENT;
+    }
+    CHECK(model_depth(cls) > 0, "transfer of class %d with nothing queued", cls);
+    if (model_depth(cls) == 0)
+    {
+        return;
+    }
+    s = &model[cls].span[model[cls].tail % SLOTS];
+
+    CHECK(data == s->data + s->sent, "class %d transfer out of order", cls);
+    CHECK(len > 0 && s->sent + len <= s->len, "transfer runs past its span");
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (data[i] != pattern(cls, s->seq, s->sent + i))
+        {
+            CHECK(false, "class %d span %lu overwritten before it went out", cls,
+                  (unsigned long)s->seq);
+            break;
+        }
+    }
+
+    if (cls == UART_TX_BULK)
+    {
+        CHECK(len <= UART_TX_BULK_CHUNK, "bulk transfer of %u bytes", len);
+        if (model_depth(UART_TX_URGENT) > 0)
+        {
+            bulk_behind++;
+            CHECK(bulk_behind <= 1, "urgent span waited behind %lu bulk chunks",
+                  (unsigned long)bulk_behind);
+        }
+    }
+    else
+    {
+        bulk_behind = 0;
+    }
+
+    sent_bytes += len;
+    s->sent = (uint16_t)(s->sent + len);
+    if (s->sent == s->len)
+    {
+        retire_due++;
+    }
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    UART_TX_CompleteISR(UART_Port_FromHandle(huart));
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    UART_TX_ErrorISR(UART_Port_FromHandle(huart));
+}
+
+/* Runs once per span leaving the queue, sent or dropped */
+void UART_TX_CompleteCallback(UART_PortTypeDef port)
+{
+    (void)port;
+    completions++;
+}
+
+static void complete(void)
+{
+    unsigned long long before = completions;
+
+    if (Host_TxComplete(PORT) == 0)
+    {
+        return;
+    }
+    CHECK(completions - before == retire_due, "%llu spans retired, %lu finished",
+          completions - before, (unsigned long)retire_due);
+    if (retire_due > 0)
+    {
+        /* The sink saw the last byte of the span at the tail of one class */
+        for (uint32_t c = 0; c < UART_TX_CLASS_COUNT; c++)
+        {
+            Model_ClassTypeDef *m = &model[c];
+
+            if (model_depth((UART_TX_ClassTypeDef)c) > 0 &&
+                m->span[m->tail % SLOTS].sent == m->span[m->tail % SLOTS].len)
+            {
+                model_pop((UART_TX_ClassTypeDef)c);
+                spans_done++;
+            }
+        }
+        retire_due = 0;
+    }
+}
+
+static void error(void)
+{
+    uint32_t retired = UART_TX_Retired(PORT);
+    unsigned long long before = completions;
+
+    if (!Host_TxBusy(PORT))
+    {
+        return;
+    }
+    Host_TxError(PORT);
+    CHECK(completions - before == 1, "dropped span retired %llu times", completions - before);
+
+    /* Whichever class was in flight lost the span at its tail */
+    if (UART_TX_Retired(PORT) != retired)
+    {
+        CHECK(UART_TX_Retired(PORT) == retired + 1U, "bulk tail moved by %lu",
+              (unsigned long)(UART_TX_Retired(PORT) - retired));
+        model_pop(UART_TX_BULK);
+    }
+    else
+    {
+        CHECK(model_depth(UART_TX_URGENT) > 0, "error dropped a span of neither class");
+        model_pop(UART_TX_URGENT);
+    }
+    bulk_behind = 0;
+    spans_dropped++;
+}
+
+static void send_bulk(void)
+{
+    UART_TX_IovTypeDef iov[4];
+    uint32_t seq[4];
+    uint8_t count = (uint8_t)(1U + rand32() % 4U);
+    uint32_t used = 0;
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        /* Gathered messages may carry empty fragments, which are skipped */
+        iov[i].len = (uint16_t)(count > 1U ? rand32() % SPAN_MAX : 1U + rand32() % (SPAN_MAX - 1U));
+        iov[i].data = span_fill(UART_TX_BULK, used, iov[i].len, &seq[i]);
+        used += (iov[i].len > 0) ? 1U : 0U;
+    }
+
+    if ((count == 1U ? UART_TX_Send(PORT, iov[0].data, iov[0].len)
+                     : UART_TX_SendIov(PORT, iov, count)) != HAL_OK)
+    {
+        CHECK(used == 0 || model_depth(UART_TX_BULK) + used > UART_TX_QUEUE_LEN,
+              "bulk refused with room in the queue");
+        return;
+    }
+    CHECK(model_depth(UART_TX_BULK) + used <= UART_TX_QUEUE_LEN,
+          "bulk accepted past the queue length");
+
+    for (i = 0; i < count; i++)
+    {
+        if (iov[i].len > 0)
+        {
+            /* Fragments are published together; tickets count up to the last */
+            model_push(UART_TX_BULK, iov[i].data, iov[i].len, seq[i],
+                       UART_TX_Queued(PORT) - (--used));
+        }
+    }
+}
+
+static void send_urgent(void)
+{
+    uint16_t len = (uint16_t)(1U + rand32() % URGENT_MAX);
+    uint32_t seq;
+    const uint8_t *p = span_fill(UART_TX_URGENT, 0, len, &seq);
+
+    if (UART_TX_SendUrgent(PORT, p, len) != HAL_OK)
+    {
+        CHECK(model_depth(UART_TX_URGENT) == UART_TX_QUEUE_LEN,
+              "urgent refused with room in the queue");
+        return;
+    }
+    model_push(UART_TX_URGENT, p, len, seq, 0);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long steps = (argc > 1) ? strtoul(argv[1], NULL, 0) : 20000000UL;
+    uint32_t start;
+    UART_TX_StatsTypeDef stats;
+
+    Host_Init(0);
+    Host_SetBaudRate(PORT, 921600);
+    Host_SetTxSink(PORT, sink);
+    Defer_Init();
+    UART_Pool_Init();
+    UART_TX_Init(PORT);
+    start = UART_TX_Queued(PORT);
+
+    for (unsigned long n = 0; n < steps; n++)
+    {
+        uint32_t r = rand32();
+
+        /* Producer and consumer rates drift so the queue runs both nearly
+           empty and full for long stretches */
+        uint32_t bias = (uint32_t)((n >> 16) & 3U);
+
+        if ((r & 1023U) == 0U)
+        {
+            error();
+        }
+        else if ((r >> 10) % 8U < 3U + bias)
+        {
+            complete();
+        }
+        else if ((r >> 14) % 8U == 0U)
+        {
+            send_urgent();
+        }
+        else
+        {
+            send_bulk();
+        }
+    }
+
+    /* Drain */
+    while (Host_TxBusy(PORT))
+    {
+        complete();
+    }
+
+    UART_TX_GetStats(PORT, &stats);
+    CHECK(UART_TX_IsIdle(PORT), "queue not idle after draining");
+    CHECK(model_depth(UART_TX_BULK) == 0 && model_depth(UART_TX_URGENT) == 0,
+          "%lu bulk and %lu urgent spans never retired",
+          (unsigned long)model_depth(UART_TX_BULK), (unsigned long)model_depth(UART_TX_URGENT));
+    CHECK(UART_TX_Retired(PORT) == UART_TX_Queued(PORT), "bulk tickets do not meet");
+    CHECK(stats.queued == stats.completed + stats.errors, "queued %lu, completed %lu, errors %lu",
+          (unsigned long)stats.queued, (unsigned long)stats.completed,
+          (unsigned long)stats.errors);
+    CHECK(stats.completed == spans_done && stats.errors == spans_dropped,
+          "statistics disagree with the model");
+    CHECK(completions == spans_done + spans_dropped, "completion callbacks miscounted");
+    CHECK(UART_TX_Queued(PORT) < start, "ring counters did not wrap");
+
+    printf("%lu steps: %llu spans sent (%lu urgent, %lu preempting), %llu dropped, "
+           "%lu rejected, %llu bytes\n", steps, spans_done, (unsigned long)stats.urgent,
+           (unsigned long)stats.preempted, spans_dropped, (unsigned long)stats.rejected,
+           sent_bytes);
+    printf("bulk counter %08lx -> %08lx, depth max %u\n", (unsigned long)start,
+           (unsigned long)UART_TX_Queued(PORT), stats.max_depth);
+
+    if (failures)
+    {
+        printf("%u failures\n", failures);
+        return 1;
+    }
+    printf("all passed\n");
+    return 0;
+}